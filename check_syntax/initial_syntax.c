@@ -53,7 +53,7 @@ char	*ft_strndup(const char *s, size_t n)
 int	is_redirection(enum e_type type)
 {
 	return (type == REDIR_IN || type == REDIR_OUT || type == DREDIR_OUT
-		|| type == HERE_DOC);
+		|| type == HERE_DOC || type == DUP_IN || type == DUP_OUT);
 }
 
 int	check_empty_line(t_data *data)
@@ -28,10 +28,12 @@ void	free_cmd(t_cmd *cmd)
 		}
 		free(cmd->full_cmd);
 	}
+	free_str_array(cmd->assigns);
 	if (cmd->in_file != -1 && cmd->in_file != STDIN_FILENO)
 		close(cmd->in_file);
 	if (cmd->out_file != -1 && cmd->out_file != STDOUT_FILENO)
 		close(cmd->out_file);
+	free_redirs(cmd->redirs);
 	free(cmd);
 }
 
@@ -60,6 +62,8 @@ void	free_token_list(t_elem *head)
 		next = current->next;
 		if (current->content)
 			free(current->content);
+		free(current->split);
+		free(current->fields);
 		free(current);
 		current = next;
 	}
@@ -0,0 +1,247 @@
+#include "minishell.h"
+
+// bench [-n N] [-w W] [--json] [--] command line ...
+// The arguments are joined into one command line, parsed once and run
+// W times to warm up, then N times measured, all in this shell so that no
+// extra shell process is part of the numbers. Each run records its wall
+// time and CPU time (the shell's own plus its waited-for children). The
+// command's stdout goes to /dev/null; the report gives min, median, p95
+// and max, as text or, with --json, as one JSON object.
+
+static int	bench_usage(void)
+{
+	ft_putstr_fd("minishell: bench: usage: bench [-n N] [-w W] [--json] "
+		"[--] command ...\n", 2);
+	return (2);
+}
+
+static int	bench_count(char **args, int *i, int *out)
+{
+	char	*val;
+
+	val = args[*i] + 2;
+	if (!*val)
+		val = args[++(*i)];
+	if (!val || !ft_isdigit(*val) || ft_strlen(val) > 9)
+		return (0);
+	*out = ft_atoi(val);
+	return (1);
+}
+
+static int	parse_bench_opts(char **args, int *i, t_bench *b)
+{
+	*i = 1;
+	while (args[*i] && args[*i][0] == '-' && args[*i][1])
+	{
+		if (!ft_strcmp(args[*i], "--"))
+		{
+			(*i)++;
+			break ;
+		}
+		if (!ft_strcmp(args[*i], "--json"))
+			b->json = 1;
+		else if (!ft_strncmp(args[*i], "-n", 2))
+		{
+			if (!bench_count(args, i, &b->runs) || b->runs <= 0)
+				return (0);
+		}
+		else if (!ft_strncmp(args[*i], "-w", 2))
+		{
+			if (!bench_count(args, i, &b->warmup))
+				return (0);
+		}
+		else
+			return (0);
+		(*i)++;
+	}
+	return (args[*i] != NULL);
+}
+
+static char	*join_words(char **words)
+{
+	char	*line;
+	char	*joined;
+
+	line = ft_strdup(words[0]);
+	while (line && *++words)
+	{
+		joined = ft_strjoin3(line, " ", *words);
+		free(line);
+		line = joined;
+	}
+	return (line);
+}
+
+// Runs list once with stdout on /dev/null; returns its status
+static int	bench_run(t_bench *b, t_node *list, int i, t_env **env_list)
+{
+	struct timespec	start;
+	struct timespec	end;
+	long			cpu;
+	int				code;
+
+	code = 0;
+	cpu = shell_cpu_usec();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	execute_list(list, &code, env_list);
+	fflush(stdout);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (i >= 0)
+	{
+		b->wall[i] = (end.tv_sec - start.tv_sec) * 1000000L
+			+ (end.tv_nsec - start.tv_nsec) / 1000;
+		b->cpu[i] = shell_cpu_usec() - cpu;
+	}
+	return (code);
+}
+
+static int	run_bench(t_bench *b, t_node *list, t_env **env_list)
+{
+	int	saved;
+	int	devnull;
+	int	i;
+	int	code;
+
+	fflush(stdout);
+	saved = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, SHELL_FD_BASE);
+	devnull = open("/dev/null", O_WRONLY);
+	if (saved < 0 || devnull < 0)
+	{
+		perror("minishell: bench");
+		if (saved >= 0)
+			close(saved);
+		return (1);
+	}
+	dup2(devnull, STDOUT_FILENO);
+	close(devnull);
+	code = 0;
+	i = -b->warmup;
+	while (i < b->runs && code != 130)
+	{
+		code = bench_run(b, list, i, env_list);
+		i++;
+	}
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+	if (code == 130)
+		b->runs = i - 1;
+	return (code);
+}
+
+static int	cmp_long(const void *a, const void *b)
+{
+	long	x;
+	long	y;
+
+	x = *(const long *)a;
+	y = *(const long *)b;
+	return ((x > y) - (x < y));
+}
+
+// Sorts v and fills min, median, p95 (nearest rank) and max
+static void	summarize(long *v, int n, long out[4])
+{
+	qsort(v, n, sizeof(long), cmp_long);
+	out[0] = v[0];
+	if (n % 2)
+		out[1] = v[n / 2];
+	else
+		out[1] = (v[n / 2 - 1] + v[n / 2]) / 2;
+	out[2] = v[(n * 95 + 99) / 100 - 1];
+	out[3] = v[n - 1];
+}
+
+static void	print_usec(long usec)
+{
+	if (usec < 1000)
+		printf(" %9ldus", usec);
+	else if (usec < 1000000)
+		printf(" %9.3fms", usec / 1000.0);
+	else
+		printf(" %9.3fs ", usec / 1000000.0);
+}
+
+static void	print_json_string(const char *s)
+{
+	printf("\"");
+	while (*s)
+	{
+		if (*s == '"' || *s == '\\')
+			printf("\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			printf("\\u%04x", (unsigned char)*s);
+		else
+			printf("%c", *s);
+		s++;
+	}
+	printf("\"");
+}
+
+static void	report_bench(t_bench *b)
+{
+	long	wall[4];
+	long	cpu[4];
+
+	summarize(b->wall, b->runs, wall);
+	summarize(b->cpu, b->runs, cpu);
+	if (b->json)
+	{
+		printf("{\"command\": ");
+		print_json_string(b->line);
+		printf(", \"runs\": %d, \"warmup\": %d, \"wall_us\": {\"min\": %ld, "
+			"\"median\": %ld, \"p95\": %ld, \"max\": %ld}, \"cpu_us\": "
+			"{\"min\": %ld, \"median\": %ld, \"p95\": %ld, \"max\": %ld}}\n",
+			b->runs, b->warmup, wall[0], wall[1], wall[2], wall[3], cpu[0],
+			cpu[1], cpu[2], cpu[3]);
+		return ;
+	}
+	printf("%s\n  %d runs, %d warmup\n", b->line, b->runs, b->warmup);
+	printf("  %-4s %11s %11s %11s %11s\n", "", "min", "median", "p95", "max");
+	printf("  wall");
+	print_usec(wall[0]);
+	print_usec(wall[1]);
+	print_usec(wall[2]);
+	print_usec(wall[3]);
+	printf("\n  cpu ");
+	print_usec(cpu[0]);
+	print_usec(cpu[1]);
+	print_usec(cpu[2]);
+	print_usec(cpu[3]);
+	printf("\n");
+}
+
+// bench: min/median/p95/max of repeated runs of one command line
+int	builtin_bench(char **args, t_env **env_list)
+{
+	t_bench	b;
+	t_node	*list;
+	int		i;
+	int		cached;
+	int		code;
+
+	ft_memset(&b, 0, sizeof(t_bench));
+	b.runs = 10;
+	if (!parse_bench_opts(args, &i, &b))
+		return (bench_usage());
+	b.line = join_words(args + i);
+	b.wall = ft_calloc(b.runs, sizeof(long));
+	b.cpu = ft_calloc(b.runs, sizeof(long));
+	list = NULL;
+	if (b.line && b.wall && b.cpu)
+		list = parse_cache_lookup(b.line, &cached, &code);
+	code = 2;
+	if (list)
+	{
+		code = run_bench(&b, list, env_list);
+		if (b.runs > 0)
+			report_bench(&b);
+		if (cached)
+			parse_cache_release(list);
+		else
+			free_node_list(list);
+	}
+	free(b.line);
+	free(b.wall);
+	free(b.cpu);
+	return (code);
+}
@@ -0,0 +1,219 @@
+#include "minishell.h"
+
+// The logical working directory. The shell keeps the path it was reached
+// by, symbolic links included, instead of asking getcwd(): "cd dir" joins
+// dir to it and resolves "." and ".." in the string, as POSIX asks of
+// cd -L, so a cd costs a single chdir() and pwd none at all. getcwd() is
+// only used for cd -P, pwd -P, and when the logical path cannot be
+// entered (a ".." above a symbolic link that went away, say); cd then
+// falls back to the physical path.
+
+static char	*g_pwd = NULL;
+
+// The logical path of dir seen from pwd, with repeated '/', "." and ".."
+// resolved
+static char	*logical_path(const char *pwd, const char *dir)
+{
+	char	*s;
+	char	*out;
+	size_t	i;
+	size_t	j;
+	size_t	n;
+
+	if (dir[0] == '/' || !pwd)
+		s = ft_strdup(dir);
+	else
+		s = ft_strjoin3(pwd, "/", dir);
+	out = NULL;
+	if (s)
+		out = malloc(ft_strlen(s) + 2);
+	i = 0;
+	j = 0;
+	while (out && s[i])
+	{
+		while (s[i] == '/')
+			i++;
+		n = 0;
+		while (s[i + n] && s[i + n] != '/')
+			n++;
+		if (n == 2 && s[i] == '.' && s[i + 1] == '.')
+			while (j > 0 && out[--j] != '/')
+				;
+		else if (n && !(n == 1 && s[i] == '.'))
+		{
+			out[j++] = '/';
+			ft_memcpy(out + j, s + i, n);
+			j += n;
+		}
+		i += n;
+	}
+	if (out && j == 0)
+		out[j++] = '/';
+	if (out)
+		out[j] = '\0';
+	free(s);
+	return (out);
+}
+
+// Takes the inherited $PWD when it names the current directory, as other
+// shells do, and exports the result
+void	pwd_init(t_env **env_list)
+{
+	struct stat	here;
+	struct stat	there;
+	char		*pwd;
+
+	pwd = get_env_value(*env_list, "PWD");
+	if (pwd && pwd[0] == '/' && stat(".", &here) == 0
+		&& stat(pwd, &there) == 0 && here.st_dev == there.st_dev
+		&& here.st_ino == there.st_ino)
+		g_pwd = logical_path(NULL, pwd);
+	if (!g_pwd)
+		g_pwd = getcwd(NULL, 0);
+	if (g_pwd)
+		set_env_value(env_list, "PWD", g_pwd);
+}
+
+// pwd [-L | -P]
+int	builtin_pwd(char **args)
+{
+	char	*cwd;
+	int		i;
+	int		physical;
+
+	physical = 0;
+	i = 1;
+	while (args[i] && (!ft_strcmp(args[i], "-L") || !ft_strcmp(args[i], "-P")))
+		physical = !ft_strcmp(args[i++], "-P");
+	if (!physical && g_pwd)
+	{
+		printf("%s\n", g_pwd);
+		return (0);
+	}
+	cwd = getcwd(NULL, 0);
+	if (!cwd)
+	{
+		perror("minishell: pwd");
+		return (1);
+	}
+	printf("%s\n", cwd);
+	free(cwd);
+	return (0);
+}
+
+// Enters dir; 0 and errno set on failure
+static int	enter_dir(const char *dir, int physical, t_env **env_list)
+{
+	char	*path;
+
+	path = NULL;
+	if (!physical)
+		path = logical_path(g_pwd, dir);
+	if (!path || chdir(path) != 0)
+	{
+		free(path);
+		if (chdir(dir) != 0)
+			return (0);
+		path = getcwd(NULL, 0);
+		if (!path)
+			path = logical_path(g_pwd, dir);
+	}
+	if (g_pwd)
+		set_env_value(env_list, "OLDPWD", g_pwd);
+	free(g_pwd);
+	g_pwd = path;
+	if (g_pwd)
+		set_env_value(env_list, "PWD", g_pwd);
+	return (1);
+}
+
+// Tries dir below every directory of CDPATH, then dir itself; a hit found
+// through a non-empty CDPATH entry is printed
+static int	cdpath_enter(const char *dir, int physical, t_env **env_list)
+{
+	char	**paths;
+	char	*full;
+	int		i;
+	int		ok;
+
+	paths = NULL;
+	if (dir[0] != '/' && strncmp(dir, "./", 2) && strncmp(dir, "../", 3)
+		&& ft_strcmp(dir, ".") && ft_strcmp(dir, "..")
+		&& get_env_value(*env_list, "CDPATH"))
+		paths = ft_split(get_env_value(*env_list, "CDPATH"), ':');
+	ok = 0;
+	i = -1;
+	while (!ok && paths && paths[++i])
+	{
+		full = ft_strjoin3(paths[i], "/", dir);
+		ok = (full && enter_dir(full, physical, env_list));
+		if (ok && g_pwd)
+			printf("%s\n", g_pwd);
+		free(full);
+	}
+	free_str_array(paths);
+	if (!ok)
+		ok = enter_dir(dir, physical, env_list);
+	return (ok);
+}
+
+static int	cd_error(const char *dir, const char *msg)
+{
+	ft_putstr_fd("minishell: cd: ", 2);
+	if (dir)
+	{
+		ft_putstr_fd((char *)dir, 2);
+		ft_putstr_fd(": ", 2);
+	}
+	ft_putendl_fd((char *)msg, 2);
+	return (1);
+}
+
+// cd -: the old directory, taken before enter_dir() replaces $OLDPWD
+static int	cd_back(int physical, t_env **env_list)
+{
+	char	*dir;
+	int		ok;
+
+	dir = ft_strdup(get_env_value(*env_list, "OLDPWD"));
+	if (!dir)
+		return (1);
+	ok = enter_dir(dir, physical, env_list);
+	if (!ok)
+		cd_error(dir, strerror(errno));
+	else if (g_pwd)
+		printf("%s\n", g_pwd);
+	free(dir);
+	return (!ok);
+}
+
+// cd [-L | -P] [dir | -]: no dir means $HOME, "-" means $OLDPWD
+int	builtin_cd(char **args, t_env **env_list)
+{
+	char	*dir;
+	int		physical;
+	int		i;
+
+	physical = 0;
+	i = 1;
+	while (args[i] && (!ft_strcmp(args[i], "-L") || !ft_strcmp(args[i], "-P")))
+		physical = !ft_strcmp(args[i++], "-P");
+	if (args[i] && !ft_strcmp(args[i], "--"))
+		i++;
+	if (args[i] && args[i + 1])
+		return (cd_error(NULL, "too many arguments"));
+	dir = args[i];
+	if (!dir && !get_env_value(*env_list, "HOME"))
+		return (cd_error(NULL, "HOME not set"));
+	if (!dir)
+		dir = get_env_value(*env_list, "HOME");
+	else if (!ft_strcmp(dir, "-") && !get_env_value(*env_list, "OLDPWD"))
+		return (cd_error(NULL, "OLDPWD not set"));
+	if (!*dir)
+		return (0);
+	if (!ft_strcmp(dir, "-"))
+		return (cd_back(physical, env_list));
+	if (!cdpath_enter(dir, physical, env_list))
+		return (cd_error(dir, strerror(errno)));
+	return (0);
+}
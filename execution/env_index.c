@@ -0,0 +1,108 @@
+#include "minishell.h"
+
+// The names of the shell's variables in order, for export's listing: a
+// skip list that env_put() and env_unset() keep up to date as names come
+// and go, so the listing walks it instead of copying and sorting the
+// table. A key goes up one more level for each leading zero bit of its
+// name's hash, which gives the usual one in two at each level without a
+// random number generator. The index follows the current version of the
+// table only.
+
+// Levels of a key, from the hash of its name
+static int	key_levels(unsigned long hash)
+{
+	int	n;
+
+	n = 1 + __builtin_clzl(hash | 1);
+	if (n > ENV_INDEX_LEVELS)
+		n = ENV_INDEX_LEVELS;
+	return (n);
+}
+
+// Fills path with the last key before name at every level; returns the
+// key at or after name on the bottom one
+static t_envkey	*key_path(t_envkey *head, const char *name, t_envkey **path)
+{
+	t_envkey	*key;
+	int			lvl;
+
+	key = head;
+	lvl = ENV_INDEX_LEVELS;
+	while (lvl--)
+	{
+		while (key->next[lvl] && ft_strcmp(key->next[lvl]->name, name) < 0)
+			key = key->next[lvl];
+		path[lvl] = key;
+	}
+	return (key->next[0]);
+}
+
+// Adds name, which is not in the index yet; 0 when out of memory
+int	env_index_add(t_env *env, const char *name, unsigned long hash)
+{
+	t_envkey	*path[ENV_INDEX_LEVELS];
+	t_envkey	*key;
+	int			n;
+
+	if (!env->index)
+		env->index = ft_calloc(1, sizeof(t_envkey)
+				+ sizeof(t_envkey *) * ENV_INDEX_LEVELS);
+	if (!env->index)
+		return (0);
+	key_path(env->index, name, path);
+	n = key_levels(hash);
+	key = ft_calloc(1, sizeof(t_envkey) + sizeof(t_envkey *) * n);
+	if (key)
+		key->name = ft_strdup(name);
+	if (!key || !key->name)
+	{
+		free(key);
+		return (0);
+	}
+	while (n--)
+	{
+		key->next[n] = path[n]->next[n];
+		path[n]->next[n] = key;
+	}
+	return (1);
+}
+
+void	env_index_del(t_env *env, const char *name)
+{
+	t_envkey	*path[ENV_INDEX_LEVELS];
+	t_envkey	*key;
+	int			lvl;
+
+	if (!env->index)
+		return ;
+	key = key_path(env->index, name, path);
+	if (!key || ft_strcmp(key->name, name))
+		return ;
+	lvl = 0;
+	while (lvl < ENV_INDEX_LEVELS && path[lvl]->next[lvl] == key)
+	{
+		path[lvl]->next[lvl] = key->next[lvl];
+		lvl++;
+	}
+	free(key->name);
+	free(key);
+}
+
+void	env_index_free(t_env *env)
+{
+	t_envkey	*key;
+	t_envkey	*next;
+
+	if (!env->index)
+		return ;
+	key = env->index->next[0];
+	while (key)
+	{
+		next = key->next[0];
+		free(key->name);
+		free(key);
+		key = next;
+	}
+	free(env->index);
+	env->index = NULL;
+}
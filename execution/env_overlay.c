@@ -0,0 +1,221 @@
+#include "minishell.h"
+
+// Per-command environments: prefix assignments ("A=1 B=2 cmd") and the
+// -i, -u and NAME=value arguments of env. An external command gets the
+// usual envp with only the slots of the names involved replaced, left out
+// or added, in a new pointer array that shares every string, so nothing
+// in the shell's variables changes and no second copy is built. A builtin
+// or a function runs in the shell: the variables are set for the time it
+// runs, over a snapshot of the table taken first (env_trie.c), and put
+// back from it afterwards.
+
+extern char	**environ;
+
+// Whether the variables "a=..." and "b=..." (or plain names) are the same
+static int	same_name(const char *a, const char *b)
+{
+	while (*a && *a != '=' && *a == *b)
+	{
+		a++;
+		b++;
+	}
+	return ((!*a || *a == '=') && (!*b || *b == '='));
+}
+
+// envp with every NAME=value of sets in the slot of NAME, or added at the
+// end, and the names of unsets left out. Only the array is allocated.
+char	**env_overlay(char **envp, char **sets, char **unsets)
+{
+	char	**out;
+	int		n;
+	int		i;
+	int		j;
+
+	n = 0;
+	while (envp && envp[n])
+		n++;
+	i = 0;
+	while (sets && sets[i])
+		i++;
+	out = malloc(sizeof(char *) * (n + i + 1));
+	n = 0;
+	i = -1;
+	while (out && envp && envp[++i])
+	{
+		j = 0;
+		while (unsets && unsets[j] && !same_name(envp[i], unsets[j]))
+			j++;
+		if (!unsets || !unsets[j])
+			out[n++] = envp[i];
+	}
+	i = -1;
+	while (out && sets && sets[++i])
+	{
+		j = 0;
+		while (j < n && !same_name(out[j], sets[i]))
+			j++;
+		out[j] = sets[i];
+		n += (j == n);
+	}
+	if (out)
+		out[n] = NULL;
+	return (out);
+}
+
+// envp for a command about to be exec'd: the array is replaced by its
+// overlay, and the strings the assignments hide are left to the exec
+char	**env_with_assigns(char **envp, char **assigns)
+{
+	char	**overlay;
+
+	overlay = env_overlay(envp, assigns, NULL);
+	if (!overlay)
+		free_str_array(envp);
+	else
+		free(envp);
+	return (overlay);
+}
+
+// Sets every NAME=value of assigns in the shell for good
+void	assigns_export(char **assigns, t_env **env_list)
+{
+	char	*eq;
+	int		i;
+
+	i = -1;
+	while (assigns && assigns[++i])
+	{
+		eq = ft_strchr(assigns[i], '=');
+		*eq = '\0';
+		set_env_value(env_list, assigns[i], eq + 1);
+		*eq = '=';
+	}
+}
+
+// Sets the assignments for the time a builtin or a function runs; the
+// variables as they were are kept in saved for assigns_restore()
+void	assigns_apply(char **assigns, t_env *env_list, t_env *saved)
+{
+	env_snapshot(env_list, saved);
+	assigns_export(assigns, &env_list);
+}
+
+// Puts back the assigned variables as saved has them. Only those: what
+// the command itself changed, a cd's $PWD say, stays.
+void	assigns_restore(char **assigns, t_env *env_list, t_env *saved)
+{
+	t_envvar	*old;
+	char		*eq;
+	int			i;
+
+	i = -1;
+	while (assigns && assigns[++i])
+	{
+		eq = ft_strchr(assigns[i], '=');
+		*eq = '\0';
+		old = env_find(saved, assigns[i]);
+		if (old)
+			env_put(env_list, old);
+		else
+			env_unset(env_list, assigns[i]);
+		*eq = '=';
+	}
+	env_node_release(saved->root);
+}
+
+// Runs argv with envp as its whole environment, looked up in envp's PATH
+static int	env_run(char **argv, char **envp)
+{
+	pid_t	pid;
+	int		status;
+
+	fflush(stdout);
+	set_child_running();
+	pid = shell_fork();
+	if (pid == 0)
+	{
+		default_signals();
+		environ = envp;
+		execvp(argv[0], argv);
+		fprintf(stderr, "env: '%s': %s\n", argv[0], strerror(errno));
+		exit(126 + (errno == ENOENT));
+	}
+	status = 0;
+	if (pid > 0)
+		wait_child(pid, &status);
+	set_child_finished();
+	if (pid < 0)
+		return (125);
+	if (WIFSIGNALED(status))
+		return (128 + WTERMSIG(status));
+	return (WEXITSTATUS(status));
+}
+
+// -i, -u NAME, then NAME=value: fills unsets and sets, returns where the
+// command starts, or -1 on a bad option
+static int	env_args(char **args, char **unsets, char **sets, int *clear)
+{
+	int	i;
+	int	n;
+
+	i = 1;
+	n = 0;
+	while (args[i] && args[i][0] == '-' && ft_strcmp(args[i], "--"))
+	{
+		if (!ft_strcmp(args[i], "-i") || !ft_strcmp(args[i], "-"))
+			*clear = 1;
+		else if (!ft_strcmp(args[i], "-u") && args[i + 1])
+			unsets[n++] = args[++i];
+		else
+		{
+			fprintf(stderr, "env: invalid option -- '%s'\n", args[i] + 1);
+			return (-1);
+		}
+		i++;
+	}
+	i += (args[i] && !ft_strcmp(args[i], "--"));
+	n = 0;
+	while (args[i] && ft_strchr(args[i], '=') && args[i][0] != '=')
+		sets[n++] = args[i++];
+	return (i);
+}
+
+// env [-i] [-u NAME]... [NAME=value]... [command [arg]...]
+int	builtin_env(char **args, t_env *env_list)
+{
+	char	**names;
+	char	**base;
+	char	**envp;
+	int		clear;
+	int		n;
+	int		i;
+
+	n = 0;
+	while (args[n])
+		n++;
+	names = ft_calloc(2 * (n + 1), sizeof(char *));
+	clear = 0;
+	i = -1;
+	if (names)
+		i = env_args(args, names, names + n + 1, &clear);
+	base = NULL;
+	if (i >= 0 && !clear)
+		base = env_to_array(env_list);
+	envp = NULL;
+	if (i >= 0 && (clear || base))
+		envp = env_overlay(base, names + n + 1, names);
+	n = 125;
+	if (envp && args[i])
+		n = env_run(args + i, envp);
+	else if (envp)
+	{
+		n = 0;
+		while (envp[n])
+			printf("%s\n", envp[n++]);
+		n = 0;
+	}
+	free(names);
+	free(envp);
+	free_str_array(base);
+	return (n);
+}
@@ -0,0 +1,408 @@
+#include "minishell.h"
+
+// The shell's variables, in a persistent hash trie. Each level uses
+// ENV_TRIE_BITS bits of a 64-bit hash of the name, and a node only stores
+// the slots in use, found with a popcount of its bitmap. Nodes and
+// variables never change once they are in a trie: setting or removing a
+// variable copies the few nodes on the way to it and shares all the rest.
+// A version of the whole table is thus one reference to its root; keeping
+// one (env_snapshot()) is O(1), and the versions kept only cost the nodes
+// they do not share. A t_env is the current version and everything that
+// changes variables goes through it. Names with equal hashes share a
+// bucket below the last level, searched in order, of up to 32 names.
+
+#define HASH_BITS 64
+
+static unsigned long	env_hash(const char *s)
+{
+	unsigned long	h;
+
+	h = 14695981039346656037UL;
+	while (*s)
+	{
+		h ^= (unsigned char)*s++;
+		h *= 1099511628211UL;
+	}
+	return (h);
+}
+
+static void	var_release(t_envvar *var)
+{
+	if (!var || --var->refs > 0)
+		return ;
+	free(var->name);
+	free(var->value);
+	free(var);
+}
+
+// Drops a reference to node, freeing what no version uses any more
+void	env_node_release(t_envnode *node)
+{
+	unsigned int	bits;
+	int				i;
+
+	if (!node || --node->refs > 0)
+		return ;
+	bits = node->map;
+	i = 0;
+	while (bits)
+	{
+		if (node->leaf & bits & -bits)
+			var_release(node->slot[i]);
+		else
+			env_node_release(node->slot[i]);
+		bits &= bits - 1;
+		i++;
+	}
+	free(node);
+}
+
+// Copy of node holding its children. op 1 leaves a gap at idx, op 0
+// leaves slot idx to the caller and op -1 drops it.
+static t_envnode	*node_edit(t_envnode *node, int idx, int op)
+{
+	t_envnode		*copy;
+	unsigned int	bits;
+	int				i;
+	int				j;
+
+	copy = ft_calloc(1, sizeof(t_envnode) + sizeof(void *)
+			* (__builtin_popcount(node->map) + op));
+	if (!copy)
+		return (NULL);
+	copy->refs = 1;
+	copy->map = node->map;
+	copy->leaf = node->leaf;
+	bits = node->map;
+	i = 0;
+	j = 0;
+	while (bits)
+	{
+		j += (i == idx && op > 0);
+		if (i == idx && op <= 0)
+			j += (op == 0);
+		else if (node->leaf & bits & -bits)
+			((t_envvar *)node->slot[i])->refs++;
+		else
+			((t_envnode *)node->slot[i])->refs++;
+		if (i != idx || op > 0)
+			copy->slot[j++] = node->slot[i];
+		bits &= bits - 1;
+		i++;
+	}
+	return (copy);
+}
+
+// Bit and index of the slot for hash at this level; in a bucket, those
+// of name, or of a new slot at the end (bit 0 when the bucket is full)
+static unsigned int	slot_of(t_envnode *node, t_envvar *key, int shift,
+		int *idx)
+{
+	unsigned int	bit;
+	int				n;
+
+	if (shift < HASH_BITS)
+	{
+		bit = 1u << ((key->hash >> shift) & ((1u << ENV_TRIE_BITS) - 1));
+		*idx = __builtin_popcount(node->map & (bit - 1));
+		return (bit);
+	}
+	n = __builtin_popcount(node->map);
+	*idx = 0;
+	while (*idx < n
+		&& ft_strcmp(((t_envvar *)node->slot[*idx])->name, key->name))
+		(*idx)++;
+	if (*idx >= (int)sizeof(node->map) * 8)
+		return (0);
+	return (1u << *idx);
+}
+
+static int	same_var(t_envvar *a, t_envvar *b)
+{
+	return (a->hash == b->hash && !ft_strcmp(a->name, b->name));
+}
+
+static t_envnode	*node_set(t_envnode *node, t_envvar *var, int shift);
+
+// Node one level down holding both cur and var
+static t_envnode	*node_split(t_envvar *cur, t_envvar *var, int shift)
+{
+	t_envnode	*empty;
+	t_envnode	*one;
+	t_envnode	*two;
+
+	empty = ft_calloc(1, sizeof(t_envnode));
+	if (!empty)
+		return (NULL);
+	empty->refs = 1;
+	one = node_set(empty, cur, shift);
+	env_node_release(empty);
+	if (!one)
+		return (NULL);
+	two = node_set(one, var, shift);
+	env_node_release(one);
+	return (two);
+}
+
+// New version of node with var in it, in place of any of the same name
+static t_envnode	*node_set(t_envnode *node, t_envvar *var, int shift)
+{
+	t_envnode		*copy;
+	void			*item;
+	unsigned int	bit;
+	int				idx;
+
+	bit = slot_of(node, var, shift, &idx);
+	if (!bit)
+		return (NULL);
+	item = var;
+	if (node->map & bit && (node->leaf & bit)
+		&& !same_var(node->slot[idx], var))
+		item = node_split(node->slot[idx], var, shift + ENV_TRIE_BITS);
+	else if (node->map & bit && !(node->leaf & bit))
+		item = node_set(node->slot[idx], var, shift + ENV_TRIE_BITS);
+	copy = NULL;
+	if (item)
+		copy = node_edit(node, idx, !(node->map & bit));
+	if (!copy)
+	{
+		if (item != var)
+			env_node_release(item);
+		return (NULL);
+	}
+	copy->slot[idx] = item;
+	copy->map |= bit;
+	copy->leaf = (copy->leaf & ~bit) | (bit * (item == var));
+	var->refs += (item == var);
+	return (copy);
+}
+
+// Sets *out to a new version of node without key, which is in it (NULL
+// when nothing is left); 0 when out of memory
+static int	node_del(t_envnode *node, t_envvar *key, int shift,
+		t_envnode **out)
+{
+	t_envnode		*sub;
+	unsigned int	bit;
+	int				idx;
+
+	bit = slot_of(node, key, shift, &idx);
+	sub = NULL;
+	if (!(node->leaf & bit)
+		&& !node_del(node->slot[idx], key, shift + ENV_TRIE_BITS, &sub))
+		return (0);
+	*out = NULL;
+	if (!sub && __builtin_popcount(node->map) == 1)
+		return (1);
+	*out = node_edit(node, idx, -(sub == NULL));
+	if (!*out)
+	{
+		env_node_release(sub);
+		return (0);
+	}
+	if (sub && sub->map == sub->leaf && __builtin_popcount(sub->map) == 1)
+	{
+		(*out)->slot[idx] = sub->slot[0];
+		((t_envvar *)sub->slot[0])->refs++;
+		(*out)->leaf |= bit;
+		env_node_release(sub);
+	}
+	else if (sub)
+		(*out)->slot[idx] = sub;
+	else if (shift >= HASH_BITS)
+		(*out)->map >>= 1;
+	else
+		(*out)->map &= ~bit;
+	(*out)->leaf &= (*out)->map;
+	return (1);
+}
+
+t_envvar	*env_find(t_env *env, const char *name)
+{
+	t_envnode		*node;
+	t_envvar		key;
+	t_envvar		*var;
+	unsigned int	bit;
+	int				shift;
+	int				idx;
+
+	key.name = (char *)name;
+	key.hash = env_hash(name);
+	node = env->root;
+	shift = 0;
+	while (node)
+	{
+		bit = slot_of(node, &key, shift, &idx);
+		if (!(node->map & bit))
+			return (NULL);
+		var = node->slot[idx];
+		if ((node->leaf & bit) && same_var(var, &key))
+			return (var);
+		if (node->leaf & bit)
+			return (NULL);
+		node = node->slot[idx];
+		shift += ENV_TRIE_BITS;
+	}
+	return (NULL);
+}
+
+static size_t	var_bytes(t_envvar *var)
+{
+	if (!var || !var->value)
+		return (0);
+	return (ft_strlen(var->name) + ft_strlen(var->value) + 2
+		+ sizeof(char *));
+}
+
+// Makes var the variable of its name in the current version. A new name
+// goes into the name index first, and leaves it again if the new version
+// cannot be built.
+int	env_put(t_env *env, t_envvar *var)
+{
+	t_envnode	*root;
+	t_envnode	*empty;
+	t_envvar	*old;
+
+	old = env_find(env, var->name);
+	if (!old && !env_index_add(env, var->name, var->hash))
+		return (0);
+	if (!var->seq && old)
+		var->seq = old->seq;
+	else if (!var->seq)
+		var->seq = env->seq + 1;
+	empty = NULL;
+	if (!env->root)
+		empty = ft_calloc(1, sizeof(t_envnode));
+	if (empty)
+		empty->refs = 1;
+	root = NULL;
+	if (empty)
+		root = node_set(empty, var, 0);
+	else if (env->root)
+		root = node_set(env->root, var, 0);
+	env_node_release(empty);
+	if (!root && !old)
+		env_index_del(env, var->name);
+	if (!root)
+		return (0);
+	env->seq += (var->seq > env->seq);
+	env->count += (old == NULL);
+	env->bytes += var_bytes(var) - var_bytes(old);
+	env_node_release(env->root);
+	env->root = root;
+	return (1);
+}
+
+// Sets name to value (NULL: declared without a value)
+int	env_set(t_env *env, const char *name, const char *value)
+{
+	t_envvar	*var;
+	int			ok;
+
+	var = ft_calloc(1, sizeof(t_envvar));
+	if (!var)
+		return (0);
+	var->name = ft_strdup(name);
+	if (value)
+		var->value = ft_strdup(value);
+	var->hash = env_hash(name);
+	var->refs = 1;
+	ok = (var->name && (var->value || !value) && env_put(env, var));
+	var_release(var);
+	return (ok);
+}
+
+int	env_unset(t_env *env, const char *name)
+{
+	t_envvar	*var;
+	t_envnode	*root;
+
+	var = env_find(env, name);
+	if (!var)
+		return (1);
+	if (!node_del(env->root, var, 0, &root))
+		return (0);
+	env_index_del(env, name);
+	env->count--;
+	env->bytes -= var_bytes(var);
+	env_node_release(env->root);
+	env->root = root;
+	return (1);
+}
+
+// Keeps the current version in snap, for env_find(), until
+// env_node_release(snap->root); the name index and the order are not
+// part of it
+void	env_snapshot(t_env *env, t_env *snap)
+{
+	*snap = *env;
+	snap->index = NULL;
+	snap->order_root = NULL;
+	snap->order = NULL;
+	if (snap->root)
+		snap->root->refs++;
+}
+
+static void	collect_vars(t_envnode *node, t_envvar **out, int *n)
+{
+	unsigned int	bits;
+	int				i;
+
+	bits = node->map;
+	i = 0;
+	while (bits)
+	{
+		if (node->leaf & bits & -bits)
+			out[(*n)++] = node->slot[i];
+		else
+			collect_vars(node->slot[i], out, n);
+		bits &= bits - 1;
+		i++;
+	}
+}
+
+static int	cmp_seq(const void *a, const void *b)
+{
+	const t_envvar	*x;
+	const t_envvar	*y;
+
+	x = *(t_envvar *const *)a;
+	y = *(t_envvar *const *)b;
+	return ((x->seq > y->seq) - (x->seq < y->seq));
+}
+
+void	env_vars_free(t_env *env)
+{
+	free(env->order);
+	env_node_release(env->order_root);
+	env->order = NULL;
+	env->order_root = NULL;
+}
+
+// Every variable of the current version, NULL-terminated, in the order
+// their names were first set. The array is sorted once per version and
+// kept with a reference to its root, so the variables in it stay alive
+// and the root is not reused for another version while it is kept; it
+// belongs to env and holds until the table next changes.
+t_envvar	**env_vars(t_env *env)
+{
+	t_envvar	**vars;
+	int			n;
+
+	if (env->order && env->order_root == env->root)
+		return (env->order);
+	vars = malloc(sizeof(t_envvar *) * (env->count + 1));
+	if (!vars)
+		return (NULL);
+	n = 0;
+	if (env->root)
+		collect_vars(env->root, vars, &n);
+	vars[n] = NULL;
+	qsort(vars, n, sizeof(t_envvar *), cmp_seq);
+	env_vars_free(env);
+	env->order = vars;
+	env->order_root = env->root;
+	if (env->root)
+		env->root->refs++;
+	return (vars);
+}
@@ -0,0 +1,286 @@
+#include "minishell.h"
+
+// Set by non-interactive callers whose process ends with the list; lets the
+// last simple command of the next top-level list be exec'd without a fork
+static int	g_exec_tail = 0;
+
+// A shell that is not interactive leaves on errors such as ${x?msg}:
+// everything that is running unwinds, as for "return", and it exits
+static int	g_interactive = 0;
+static int	g_fatal = 0;
+
+void	set_tail_exec(int enabled)
+{
+	g_exec_tail = enabled;
+}
+
+void	set_interactive(int enabled)
+{
+	g_interactive = enabled;
+}
+
+// Reports an error after which a non-interactive shell must exit
+void	fatal_error(void)
+{
+	if (!g_interactive)
+		g_fatal = 1;
+}
+
+int	shell_failed(void)
+{
+	return (g_fatal);
+}
+
+// Whether the commands running must stop: "return" or a fatal error
+static int	unwinding(void)
+{
+	return (g_fatal || function_returning());
+}
+
+// Expands, parses and runs one pipeline of a command list. Expansion works
+// on a copy so that the list can be run again (parse cache, loops).
+int	run_pipeline_node(t_elem *tokens, int tail, int *last_exit_code,
+		t_env **env_list)
+{
+	t_data	data;
+	int		ok;
+	int		psubs;
+
+	ft_memset(&data, 0, sizeof(t_data));
+	data.elem = copy_token_list(tokens);
+	if (!data.elem)
+		return (0);
+	data.tail = tail;
+	data.n_env = *env_list;
+	psubs = proc_subst_mark();
+	subst_status_reset();
+	if (!expand_tokens(data.elem, *last_exit_code, *env_list))
+	{
+		reap_proc_substs(psubs);
+		free_token_list(data.elem);
+		*last_exit_code = 1;
+		return (0);
+	}
+	ok = parse_pipeline(&data);
+	glob_cache_clear();
+	if (!ok && data.file_error)
+		*last_exit_code = 1;
+	else if (ok)
+	{
+		data.exit_status = *last_exit_code;
+		*last_exit_code = execute_pipeline(&data, env_list);
+	}
+	free_cmd_list(data.head);
+	free_token_list(data.elem);
+	reap_proc_substs(psubs);
+	return (ok);
+}
+
+// "for name; do" loops over the positional parameters
+static char	**positional_words(void)
+{
+	t_frame	*frame;
+	char	**words;
+	int		i;
+
+	frame = current_frame();
+	words = ft_calloc(frame->count + 1, sizeof(char *));
+	i = 1;
+	while (words && i < frame->count)
+	{
+		words[i - 1] = ft_strdup(frame->args[i]);
+		if (!words[i - 1])
+		{
+			free_str_array(words);
+			return (NULL);
+		}
+		i++;
+	}
+	return (words);
+}
+
+// Expands the words of a for loop once, before the first iteration
+static char	**expand_for_words(t_node *node, int last_exit_code,
+		t_env *env_list)
+{
+	t_data	data;
+	t_elem	*current;
+	t_cmd	*cmd;
+	char	**words;
+
+	if (!node->has_in)
+		return (positional_words());
+	if (!node->tokens)
+		return (ft_calloc(1, sizeof(char *)));
+	ft_memset(&data, 0, sizeof(t_data));
+	data.n_env = env_list;
+	data.words_only = 1;
+	data.elem = copy_token_list(node->tokens);
+	if (!data.elem)
+		return (NULL);
+	if (!expand_tokens(data.elem, last_exit_code, env_list))
+	{
+		free_token_list(data.elem);
+		return (NULL);
+	}
+	current = data.elem;
+	skip_whitespace_ptr(&current);
+	cmd = parse_command(&data, &current);
+	glob_cache_clear();
+	free_token_list(data.elem);
+	if (!cmd)
+		return (NULL);
+	words = cmd->full_cmd;
+	cmd->full_cmd = NULL;
+	free_cmd(cmd);
+	if (!words)
+		return (ft_calloc(1, sizeof(char *)));
+	return (words);
+}
+
+// A loop stops when a command in it was killed by SIGINT, like bash does,
+// or when "return" is leaving the function
+static int	loop_interrupted(int last_exit_code)
+{
+	return (last_exit_code == 128 + SIGINT || unwinding());
+}
+
+static int	run_for(t_node *node, int *last_exit_code, t_env **env_list)
+{
+	char	**words;
+	int		status;
+	int		i;
+	int		psubs;
+
+	psubs = proc_subst_mark();
+	words = expand_for_words(node, *last_exit_code, *env_list);
+	if (!words)
+	{
+		reap_proc_substs(psubs);
+		return (*last_exit_code = 1);
+	}
+	status = 0;
+	i = 0;
+	while (words[i] && !loop_interrupted(status))
+	{
+		if (!set_env_value(env_list, node->var, words[i++]))
+			break ;
+		status = execute_list(node->body, last_exit_code, env_list);
+	}
+	free_str_array(words);
+	reap_proc_substs(psubs);
+	return (*last_exit_code = status);
+}
+
+// while runs the body as long as the condition succeeds, until as long as
+// it fails; the status is the one of the last body run, or 0
+static int	run_loop(t_node *node, int *last_exit_code, t_env **env_list)
+{
+	int	status;
+
+	status = 0;
+	while (!loop_interrupted(status))
+	{
+		execute_list(node->cond, last_exit_code, env_list);
+		if (loop_interrupted(*last_exit_code))
+			return (*last_exit_code);
+		if ((*last_exit_code == 0) != (node->kind == NODE_WHILE))
+			break ;
+		status = execute_list(node->body, last_exit_code, env_list);
+	}
+	return (*last_exit_code = status);
+}
+
+static int	run_if(t_node *node, int *last_exit_code, t_env **env_list)
+{
+	execute_list(node->cond, last_exit_code, env_list);
+	if (unwinding())
+		return (*last_exit_code);
+	if (*last_exit_code == 0)
+		return (execute_list(node->body, last_exit_code, env_list));
+	if (node->alt)
+		return (execute_list(node->alt, last_exit_code, env_list));
+	return (*last_exit_code = 0);
+}
+
+// Runs one command of a list; only a plain pipeline may be a tail call
+int	run_command_node(t_node *node, int tail, int *last_exit_code,
+		t_env **env_list)
+{
+	if (node->kind == NODE_IF)
+		return (run_if(node, last_exit_code, env_list));
+	if (node->kind == NODE_WHILE || node->kind == NODE_UNTIL)
+		return (run_loop(node, last_exit_code, env_list));
+	if (node->kind == NODE_FOR)
+		return (run_for(node, last_exit_code, env_list));
+	if (node->kind == NODE_GROUP)
+		return (execute_list(node->body, last_exit_code, env_list));
+	if (node->kind == NODE_FUNCDEF)
+		return (*last_exit_code = define_function(node->var, node->body));
+	return (run_pipeline_node(node->tokens, tail, last_exit_code,
+			env_list));
+}
+
+static int	run_node(t_node *node, int tail, int *last_exit_code,
+		t_env **env_list)
+{
+	if (node->timed)
+		return (time_command(node, last_exit_code, env_list));
+	return (run_command_node(node, tail, last_exit_code, env_list));
+}
+
+// Returns the last pipeline of the and-or list that starts at node
+static t_node	*and_or_end(t_node *node)
+{
+	while (node->next && (node->op == OP_AND || node->op == OP_OR))
+		node = node->next;
+	return (node);
+}
+
+// Runs node..end left to right; "&&" skips the next pipeline after a
+// failure and "||" after a success, which gives the POSIX left-associative
+// evaluation of a && b || c.
+int	run_and_or(t_node *node, t_node *end, int *last_exit_code,
+		t_env **env_list)
+{
+	enum e_list_op	prev_op;
+	int				tail;
+
+	prev_op = OP_SEQ;
+	tail = g_exec_tail;
+	g_exec_tail = 0;
+	while (node && !unwinding())
+	{
+		if (!(prev_op == OP_AND && *last_exit_code != 0)
+			&& !(prev_op == OP_OR && *last_exit_code == 0))
+			run_node(node, tail && !node->next, last_exit_code, env_list);
+		if (node == end)
+			break ;
+		prev_op = node->op;
+		node = node->next;
+	}
+	return (*last_exit_code);
+}
+
+int	execute_list(t_node *list, int *last_exit_code, t_env **env_list)
+{
+	t_node	*end;
+	int		tail;
+
+	tail = g_exec_tail;
+	g_exec_tail = 0;
+	while (list && !unwinding())
+	{
+		end = and_or_end(list);
+		if (end->op == OP_BACKGROUND)
+			launch_background_job(list, end, last_exit_code, env_list);
+		else
+		{
+			g_exec_tail = (tail && !end->next);
+			run_and_or(list, end, last_exit_code, env_list);
+		}
+		list = end->next;
+	}
+	g_exec_tail = 0;
+	return (*last_exit_code);
+}
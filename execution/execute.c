@@ -36,71 +36,26 @@ void	free_str_array(char **arr)
 
 // ======================== ENVIRONMENT UTILS ============================ //
 
-t_env    *create_env_node(const char *env)
-{
-    t_env    *node;
-    char    *sep;
-
-    if (!env)
-        return (NULL);
-    node = malloc(sizeof(t_env));
-    if (!node)
-        return (NULL);
-    sep = strchr(env, '=');
-    if (!sep)
-    {
-        node->name = ft_strdup(env);
-        if (!node->name)
-            return (free(node), NULL);
-        node->value = NULL;
-        node->next = NULL;
-        return (node);
-    }
-    else
-        node->name = ft_strndup(env, sep - env);    
-    if (!node->name)
-        return (free(node), NULL);
-    node->value = strdup(sep + 1);
-    if (!node->value)
-        return (free(node->name), free(node), NULL);
-
-    node->next = NULL;
-    return (node);
-}
-
-void    add_env_back(t_env **lst, t_env *new_node)
-{
-    t_env    *temp;
-
-    if (!lst || !new_node)
-        return ;
-    if (!*lst)
-    {
-        *lst = new_node;
-        return ;
-    }
-    temp = *lst;
-    while (temp->next)
-        temp = temp->next;
-    temp->next = new_node;
-}
-
-// Modified to return the created environment list instead of using global
+// The variables of envp; an empty table when there are none
 t_env    *init_env_list(char **envp)
 {
-    int        i;
-    t_env    *node;
     t_env    *env_list;
+    char    *sep;
+    int        i;
 
+    env_list = ft_calloc(1, sizeof(t_env));
     i = 0;
-    env_list = NULL;
-    if (!envp)
-        return (NULL);
-    while (envp[i])
+    while (env_list && envp && envp[i])
     {
-        node = create_env_node(envp[i]);
-        if (node)
-            add_env_back(&env_list, node);
+        sep = ft_strchr(envp[i], '=');
+        if (sep)
+        {
+            *sep = '\0';
+            env_set(env_list, envp[i], sep + 1);
+            *sep = '=';
+        }
+        else
+            env_set(env_list, envp[i], NULL);
         i++;
     }
     return (env_list);
@@ -108,36 +63,33 @@ t_env    *init_env_list(char **envp)
 
 void    free_env_list(t_env *env)
 {
-    t_env    *tmp;
-
-    while (env)
-    {
-        tmp = env;
-        env = env->next;
-        if (tmp->name)
-            free(tmp->name);
-        if (tmp->value)
-            free(tmp->value);
-        free(tmp);
-    }
+    if (!env)
+        return ;
+    env_node_release(env->root);
+    env_vars_free(env);
+    env_index_free(env);
+    free(env);
 }
 
 // Modified to take env_list as parameter
 char    *get_env_value(t_env *env_list, char *key)
 {
-    t_env    *tmp;
+    t_envvar    *var;
 
-    tmp = env_list;
-    if (!key)
+    if (!env_list || !key)
         return (NULL);
-    while (tmp)
-    {
-        if (tmp->name && !ft_strcmp(tmp->name, key))
-            return (tmp->value);
-        tmp = tmp->next;
-    }
-    return (NULL);
+    var = env_find(env_list, key);
+    if (!var)
+        return (NULL);
+    return (var->value);
 }
+
+// Sets name to value, adding the variable if it is new
+int set_env_value(t_env **env_list, char *name, char *value)
+{
+    return (env_set(*env_list, name, value));
+}
+
 static char *search_in_paths(char **paths, char *cmd)
 {
     char *full;
@@ -155,12 +107,33 @@ static char *search_in_paths(char **paths, char *cmd)
     return (NULL);
 }
 
+// Walks PATH for cmd and remembers the result in the path cache
+static char *search_command(char *cmd, char *env_path)
+{
+    char **paths;
+    char *result;
+
+    paths = ft_split(env_path, ':');
+    if (!paths)
+        return (NULL);
+    result = search_in_paths(paths, cmd);
+    free_str_array(paths);
+    if (result)
+        path_cache_add(cmd, env_path, result);
+    return (result);
+}
+
+// The command word and $PATH string of the last path_cache_prime(): a
+// child that looks the same strings up has had its lookup counted already
+static const char *g_primed_cmd = NULL;
+static const char *g_primed_path = NULL;
+
 // Modified to take env_list as parameter
 char *get_cmd_path(char *cmd, t_env *env_list)
 {
-    char **paths;
     char *env_path;
     char *result;
+    int counted;
     
     if (!cmd)
         return (NULL);
@@ -169,28 +142,45 @@ char *get_cmd_path(char *cmd, t_env *env_list)
     env_path = get_env_value(env_list, "PATH");
     if (!env_path)
         return (ft_strdup(cmd));
-    paths = ft_split(env_path, ':');
-    if (!paths)
-        return (NULL);
-    result = search_in_paths(paths, cmd);
-    free_str_array(paths);
-    return (result);
+    counted = (cmd == g_primed_cmd && env_path == g_primed_path);
+    g_primed_cmd = NULL;
+    if (!counted)
+        stats_count(STAT_PATH_LOOKUPS, 1);
+    result = path_cache_find(cmd, env_path, 1);
+    if (result)
+    {
+        if (!counted)
+            stats_count(STAT_PATH_HITS, 1);
+        return (result);
+    }
+    return (search_command(cmd, env_path));
 }
 
-//env_norm_start
-static int count_valid_env_vars(t_env *env)
+// Looks cmd up in the shell before a fork, so that the child, which does
+// the real lookup, finds it in its copy of the path cache. The lookup and
+// whether it hit are counted here, not in the child.
+void path_cache_prime(char *cmd, t_env *env_list)
 {
-    int count = 0;
-    
-    while (env)
-    {
-        if (env->name && env->value)
-            count++;
-        env = env->next;
-    }
-    return count;
+    char *env_path;
+    char *path;
+
+    if (!cmd || ft_strchr(cmd, '/') || is_builtin(cmd) || find_function(cmd))
+        return ;
+    env_path = get_env_value(env_list, "PATH");
+    if (!env_path)
+        return ;
+    stats_count(STAT_PATH_LOOKUPS, 1);
+    path = path_cache_find(cmd, env_path, 0);
+    if (path)
+        stats_count(STAT_PATH_HITS, 1);
+    else
+        path = search_command(cmd, env_path);
+    free(path);
+    g_primed_cmd = cmd;
+    g_primed_path = env_path;
 }
 
+//env_norm_start
 static void cleanup_array_on_failure(char **arr, int i)
 {
     while (--i >= 0)
@@ -213,47 +203,38 @@ static char *create_env_string(char *name, char *value)
 
 char **env_to_array(t_env *env)
 {
-    int count, i = 0;
+    t_envvar **vars;
     char **arr;
+    int i = 0, j = 0;
     
-    count = count_valid_env_vars(env);
-    arr = malloc(sizeof(char *) * (count + 1));
-    if (!arr)
+    stats_count(STAT_ENV_REBUILDS, 1);
+    vars = env_vars(env);
+    if (!vars)
         return (NULL);
-    while (env && i < count)
+    arr = malloc(sizeof(char *) * (env->count + 1));
+    while (arr && vars[j])
     {
-        if (env->name && env->value)
+        if (vars[j]->value)
         {
-            arr[i] = create_env_string(env->name, env->value);
+            arr[i] = create_env_string(vars[j]->name, vars[j]->value);
             if (!arr[i])
             {
                 cleanup_array_on_failure(arr, i);
-                return (NULL);
+                arr = NULL;
+                break ;
             }
             i++;
         }
-        env = env->next;
+        j++;
     }
-    arr[i] = NULL;
+    if (arr)
+        arr[i] = NULL;
     return (arr);
 }
 //env_norm_end
 
 // ======================== BUILT-IN COMMANDS ============================ //
 
-int	builtin_pwd(void)
-{
-	char	cwd[1024];
-
-	if (getcwd(cwd, sizeof(cwd)))
-	{
-		printf("%s\n", cwd);
-		return (0);
-	}
-	perror("pwd");
-	return (1);
-}
-
 int	builtin_echo(char **args)
 {
 	int	i;
@@ -280,20 +261,6 @@ int	builtin_echo(char **args)
 	return (0);
 }
 
-int    builtin_env(t_env *env_list)
-{
-    t_env    *tmp;
-
-    tmp = env_list;
-    while (tmp)
-    {
-        if (tmp->name && tmp->value)
-            printf("%s=%s\n", tmp->name, tmp->value);
-        tmp = tmp->next;
-    }
-    return (0);
-}
-
 // Modified to take env_list as parameter
 int	builtin_exit(char **args, t_env *env_list)
 {
@@ -309,82 +276,44 @@ int	builtin_exit(char **args, t_env *env_list)
 /*the export logic */
 /* ---------------------- DISPLAY FUNCTIONS ---------------------- */
 
-// Modified to take env_list as parameter
+// Lists the variables in name order, straight off the name index
 static void print_exported_vars(t_env *env_list)
 {
-    t_env *tmp = env_list;
-    
-    while (tmp)
+    t_envkey *key;
+    t_envvar *var;
+
+    key = NULL;
+    if (env_list->index)
+        key = env_list->index->next[0];
+    while (key)
     {
-        if (tmp->value)
-            printf("declare -x %s=\"%s\"\n", tmp->name, tmp->value);
-        else
-            printf("declare -x %s\n", tmp->name);
-        tmp = tmp->next;
+        var = env_find(env_list, key->name);
+        if (var && var->value)
+            printf("declare -x %s=\"%s\"\n", var->name, var->value);
+        else if (var)
+            printf("declare -x %s\n", var->name);
+        key = key->next[0];
     }
 }
 
-/* ---------------------- VARIABLE UPDATE FUNCTIONS ---------------------- */
-
-static int update_existing_var(t_env *node, char *new_value)
-{
-    if (!node || !new_value)
-        return (0);
-    
-    if (node->value)
-        free(node->value);
-    node->value = ft_strdup(new_value);
-    return (1);
-}
-
-// Modified to take env_list as parameter
-static int create_new_var(char *name, char *value, t_env **env_list)
-{
-	t_env *new_node;
-	char *full_var;
-
-	if (!name)
-		return (0);
-
-	if (!value)
-		full_var = ft_strdup(name);
-	else
-		full_var = ft_strjoin3(name, "=", value);
-	if (!full_var)
-		return (0);
-	new_node = create_env_node(full_var);
-	free(full_var);
-	if (!new_node)
-		return (0);
-
-	add_env_back(env_list, new_node);
-	return (1);
-}
-
 /* ---------------------- ARGUMENT PROCESSING ---------------------- */
 
-// Modified to take env_list as parameter
+// NAME=value sets NAME; a bare NAME is declared, keeping any value it has
 static int process_var_assignment(char *arg, t_env **env_list)
 {
     char *sep = ft_strchr(arg, '=');
-    t_env *tmp;
+    int ret;
 
     if (!sep)
-        return (create_new_var(arg, NULL, env_list));
-    
-    *sep = '\0';  // Temporarily split at '='
-    tmp = *env_list;
-    while (tmp)
     {
-        if (tmp->name && !ft_strcmp(tmp->name, arg))
-        {
-            *sep = '=';
-            return update_existing_var(tmp, sep + 1);
-        }
-        tmp = tmp->next;
+        if (env_find(*env_list, arg))
+            return (1);
+        return (env_set(*env_list, arg, NULL));
     }
+    *sep = '\0';  // Temporarily split at '='
+    ret = env_set(*env_list, arg, sep + 1);
     *sep = '=';
-    return create_new_var(arg, sep + 1, env_list);
+    return (ret);
 }
 
 /* ---------------------- MAIN EXPORT FUNCTION ---------------------- */
@@ -414,33 +343,9 @@ int builtin_export(char **args, t_env **env_list)
 /*the end of it */
 
 // Modified to take env_list as parameter
-static int unset_single_var(char *var_name, t_env **env_list)
+int unset_single_var(char *var_name, t_env **env_list)
 {
-    t_env *tmp, *prev;
-    
-    tmp = *env_list;
-    prev = NULL;
-    
-    while (tmp)
-    {
-        if (tmp->name && !ft_strcmp(tmp->name, var_name))
-        {
-            if (prev)
-                prev->next = tmp->next;
-            else
-                *env_list = tmp->next;
-            if (tmp->name)
-                free(tmp->name);
-            if (tmp->value)
-                free(tmp->value);
-            free(tmp);
-            
-            return (1); // Variable found and removed
-        }
-        prev = tmp;
-        tmp = tmp->next;
-    }
-    return (0); // Variable not found
+    return (env_unset(*env_list, var_name));
 }
 
 // Modified to take env_list as parameter
@@ -461,39 +366,20 @@ int builtin_unset(char **args, t_env **env_list)
     return (0);
 }
 
-// Modified to take env_list as parameter
-int	builtin_cd(char **args, t_env *env_list)
-{
-	char	*home;
-
-	if (!args || !args[0])
-		return (1);
-	if (!args[1])
-	{
-		home = get_env_value(env_list, "HOME");
-		if (!home)
-			return (1);
-		if (chdir(home) != 0)
-		{
-			perror("cd");
-			return (1);
-		}
-	}
-	else if (chdir(args[1]) != 0)
-	{
-		perror("cd");
-		return (1);
-	}
-	return (0);
-}
-
 int	is_builtin(char *cmd)
 {
 	if (!cmd)
 		return (0);
 	return (!ft_strcmp(cmd, "cd") || !ft_strcmp(cmd, "echo") || !ft_strcmp(cmd,
 			"pwd") || !ft_strcmp(cmd, "export") || !ft_strcmp(cmd, "unset")
-		|| !ft_strcmp(cmd, "env") || !ft_strcmp(cmd, "exit"));
+		|| !ft_strcmp(cmd, "env") || !ft_strcmp(cmd, "exit")
+		|| !ft_strcmp(cmd, "parallel") || !ft_strcmp(cmd, "jobs")
+		|| !ft_strcmp(cmd, "wait") || !ft_strcmp(cmd, "parsecache")
+		|| !ft_strcmp(cmd, "return") || !ft_strcmp(cmd, "test")
+		|| !ft_strcmp(cmd, "[") || !ft_strcmp(cmd, "[[")
+		|| !ft_strcmp(cmd, "exec") || !ft_strcmp(cmd, "times")
+		|| !ft_strcmp(cmd, "bench")
+		|| !ft_strcmp(cmd, "shellstats"));
 }
 
 // Modified to take env_list as parameter
@@ -504,17 +390,39 @@ int	exec_builtin(t_cmd *cmd, t_env **env_list)
 	if (!ft_strcmp(cmd->full_cmd[0], "echo"))
 		return (builtin_echo(cmd->full_cmd));
 	if (!ft_strcmp(cmd->full_cmd[0], "cd"))
-		return (builtin_cd(cmd->full_cmd, *env_list));
+		return (builtin_cd(cmd->full_cmd, env_list));
 	if (!ft_strcmp(cmd->full_cmd[0], "pwd"))
-		return (builtin_pwd());
+		return (builtin_pwd(cmd->full_cmd));
 	if (!ft_strcmp(cmd->full_cmd[0], "export"))
 		return (builtin_export(cmd->full_cmd, env_list));
 	if (!ft_strcmp(cmd->full_cmd[0], "unset"))
 		return (builtin_unset(cmd->full_cmd, env_list));
 	if (!ft_strcmp(cmd->full_cmd[0], "env"))
-		return (builtin_env(*env_list));
+		return (builtin_env(cmd->full_cmd, *env_list));
 	if (!ft_strcmp(cmd->full_cmd[0], "exit"))
 		return (builtin_exit(cmd->full_cmd, *env_list));
+	if (!ft_strcmp(cmd->full_cmd[0], "parallel"))
+		return (builtin_parallel(cmd->full_cmd, env_list));
+	if (!ft_strcmp(cmd->full_cmd[0], "jobs"))
+		return (builtin_jobs(cmd->full_cmd));
+	if (!ft_strcmp(cmd->full_cmd[0], "wait"))
+		return (builtin_wait(cmd->full_cmd));
+	if (!ft_strcmp(cmd->full_cmd[0], "parsecache"))
+		return (builtin_parsecache(cmd->full_cmd));
+	if (!ft_strcmp(cmd->full_cmd[0], "return"))
+		return (builtin_return(cmd->full_cmd));
+	if (!ft_strcmp(cmd->full_cmd[0], "test")
+		|| !ft_strcmp(cmd->full_cmd[0], "[")
+		|| !ft_strcmp(cmd->full_cmd[0], "[["))
+		return (builtin_test(cmd->full_cmd));
+	if (!ft_strcmp(cmd->full_cmd[0], "exec"))
+		return (builtin_exec(cmd, env_list, 0));
+	if (!ft_strcmp(cmd->full_cmd[0], "times"))
+		return (builtin_times());
+	if (!ft_strcmp(cmd->full_cmd[0], "bench"))
+		return (builtin_bench(cmd->full_cmd, env_list));
+	if (!ft_strcmp(cmd->full_cmd[0], "shellstats"))
+		return (builtin_shellstats(cmd->full_cmd));
 	return (1);
 }
 
@@ -534,7 +442,9 @@ int	execute_builtin_command(t_cmd *cmd, t_env **env_list)
 		saved_stdout = dup(STDOUT_FILENO);
 		dup2(cmd->out_file, STDOUT_FILENO);
 	}
+	save_fd_redirs(cmd);
 	ret = exec_builtin(cmd, env_list);
+	restore_fd_redirs(cmd);
 	if (saved_stdin != -1)
 	{
 		dup2(saved_stdin, STDIN_FILENO);
@@ -565,6 +475,8 @@ void	setup_and_exec_child(t_cmd *cmd, char **envp, t_env *env_list)
 		dup2(cmd->out_file, STDOUT_FILENO);
 		close(cmd->out_file);
 	}
+	apply_fd_redirs(cmd);
+	assigns_export(cmd->assigns, &env_list);
 	path = get_cmd_path(cmd->full_cmd[0], env_list);
 	if (!path)
 	{
@@ -572,6 +484,7 @@ void	setup_and_exec_child(t_cmd *cmd, char **envp, t_env *env_list)
 		free_str_array(envp);
 		exit(127);
 	}
+	stats_exec();
 	execve(path, cmd->full_cmd, envp);
 	perror(path);
 	free(path);
@@ -579,6 +492,22 @@ void	setup_and_exec_child(t_cmd *cmd, char **envp, t_env *env_list)
 	exit(127);
 }
 
+// Tail-call exec: when nothing runs after this command the shell replaces
+// itself with it instead of forking and sitting in waitpid()
+int	exec_in_place(t_cmd *cmd, t_env **env_list)
+{
+	char	**envp;
+
+	envp = env_to_array(*env_list);
+	if (envp && cmd->assigns)
+		envp = env_with_assigns(envp, cmd->assigns);
+	if (!envp)
+		return (1);
+	fflush(stdout);
+	setup_and_exec_child(cmd, envp, *env_list);
+	return (127);
+}
+
 // Function 3: Handle fork and child process execution
 // Modified to take env_list as parameter
 int	fork_and_execute(t_cmd *cmd, char **envp, t_env *env_list)
@@ -587,7 +516,8 @@ int	fork_and_execute(t_cmd *cmd, char **envp, t_env *env_list)
 	int		status;
 	int		ret;
 
-	pid = fork();
+	path_cache_prime(cmd->full_cmd[0], env_list);
+	pid = shell_fork();
 	if (pid == 0)
 	{
 		setup_and_exec_child(cmd, envp, env_list);
@@ -597,7 +527,7 @@ int	fork_and_execute(t_cmd *cmd, char **envp, t_env *env_list)
 		perror("fork");
 		return (1);
 	}
-	waitpid(pid, &status, 0);
+	wait_child(pid, &status);
 	if (WIFSIGNALED(status))
 		ret = 128 + WTERMSIG(status);
 	else if (WIFEXITED(status))
@@ -611,22 +541,42 @@ int	fork_and_execute(t_cmd *cmd, char **envp, t_env *env_list)
 // Modified to take env_list as parameter
 int	execute_single_command(t_cmd *cmd, t_env **env_list)
 {
-	char	**envp;
-	int		ret;
+	char		**envp;
+	char		**overlay;
+	int			ret;
+	t_node		*func;
+	t_env		saved;
 
 	if (!cmd || !cmd->full_cmd || !cmd->full_cmd[0])
 		return (1);
-	if (is_builtin(cmd->full_cmd[0]))
-		return (execute_builtin_command(cmd, env_list));
+	func = find_function(cmd->full_cmd[0]);
+	if (!ft_strcmp(cmd->full_cmd[0], "exec"))
+		return (builtin_exec(cmd, env_list, 1));
+	if (func || is_builtin(cmd->full_cmd[0]))
+	{
+		assigns_apply(cmd->assigns, *env_list, &saved);
+		if (func)
+			ret = run_function_command(cmd, func, env_list);
+		else
+			ret = execute_builtin_command(cmd, env_list);
+		assigns_restore(cmd->assigns, *env_list, &saved);
+		return (ret);
+	}
 	set_child_running();
 	envp = env_to_array(*env_list);
-	if (!envp)
+	overlay = envp;
+	if (envp && cmd->assigns)
+		overlay = env_overlay(envp, cmd->assigns, NULL);
+	if (!overlay)
 	{
 		set_child_finished();
+		free_str_array(envp);
 		return (1);
 	}
-	ret = fork_and_execute(cmd, envp, *env_list);
+	ret = fork_and_execute(cmd, overlay, *env_list);
 	set_child_finished();
+	if (overlay != envp)
+		free(overlay);
 	free_str_array(envp);
 	return (ret);
 }
@@ -682,7 +632,18 @@ void	execute_child_command(t_cmd *cmd, char **envp, t_env **env_list)
 {
 	char	*path;
 	int		ret;
+	t_node	*func;
 
+	assigns_export(cmd->assigns, env_list);
+	if (cmd->assigns)
+		envp = env_with_assigns(envp, cmd->assigns);
+	func = find_function(cmd->full_cmd[0]);
+	if (func)
+	{
+		ret = call_function(func, cmd->full_cmd, env_list);
+		free_str_array(envp);
+		exit(ret);
+	}
 	if (is_builtin(cmd->full_cmd[0]))
 	{
 		ret = exec_builtin(cmd, env_list);
@@ -696,6 +657,7 @@ void	execute_child_command(t_cmd *cmd, char **envp, t_env **env_list)
 		free_str_array(envp);
 		exit(127);
 	}
+	stats_exec();
 	execve(path, cmd->full_cmd, envp);
 	perror(path);
 	free(path);
@@ -709,12 +671,15 @@ int	handle_child_process(t_cmd *cmd, int *pipefd, int prev_fd, char **envp, t_en
 {
 	pid_t	pid;
 
-	pid = fork();
+	path_cache_prime(cmd->full_cmd[0], *env_list);
+	pid = shell_fork();
+	cmd->pid = pid;
 	if (pid == 0)
 	{
 		default_signals();
 		handle_input_redirection(cmd, prev_fd);
 		handle_output_redirection(cmd, pipefd);
+		apply_fd_redirs(cmd);
 		if (cmd->next)
 			close(pipefd[0]);
 		execute_child_command(cmd, envp, env_list);
@@ -802,43 +767,64 @@ int	execute_pipeline_commands(t_cmd *cmd, char **envp, t_env **env_list)
 	return (0);
 }
 
-// Function 3: Wait for children and cleanup
-int	wait_and_cleanup(char **envp)
+// Function 3: Wait for this pipeline's children and cleanup. Only our own
+// pids are waited for, so background jobs are left to the job reaper.
+int	wait_and_cleanup(t_cmd *cmd, char **envp)
 {
 	int	status;
 	int	last_exit_status;
 
 	last_exit_status = 0;
-	while (wait(&status) > 0)
+	while (cmd)
 	{
-		if (WIFSIGNALED(status))
-			last_exit_status = 128 + WTERMSIG(status);
-		else if (WIFEXITED(status))
-			last_exit_status = WEXITSTATUS(status);
+		if (cmd->full_cmd && cmd->full_cmd[0] && cmd->pid > 0
+			&& wait_child(cmd->pid, &status) == cmd->pid)
+		{
+			if (WIFSIGNALED(status))
+				last_exit_status = 128 + WTERMSIG(status);
+			else if (WIFEXITED(status))
+				last_exit_status = WEXITSTATUS(status);
+		}
+		cmd = cmd->next;
 	}
 	set_child_finished();
 	free_str_array(envp);
 	return (last_exit_status);
 }
 
-// Main function: Execute pipeline (orchestrates the 3 parts)
-// Modified to take env_list as parameter
+// Main function: Execute pipeline (orchestrates the 3 parts). A command
+// of assignments only has the status of its last command substitution.
 int	execute_pipeline(t_data *data, t_env **env_list)
 {
 	char	**envp;
+	int		status;
 
+	stats_count(STAT_COMMANDS, count_commands(data->head));
+	if (data->head && !data->head->next && data->head->assigns
+		&& (!data->head->full_cmd || !data->head->full_cmd[0]))
+	{
+		assigns_export(data->head->assigns, env_list);
+		status = subst_status();
+		return (status * (status > 0));
+	}
 	envp = init_pipeline(data, *env_list);
 	if (!envp)
 		return (1);
+	set_caller_status(data->exit_status);
 	if (envp == (char **)1)
+	{
+		if (data->tail && data->head->full_cmd
+			&& !is_builtin(data->head->full_cmd[0])
+			&& !find_function(data->head->full_cmd[0]))
+			return (exec_in_place(data->head, env_list));
 		return (execute_single_command(data->head, env_list));
+	}
 	if (execute_pipeline_commands(data->head, envp, env_list) == -1)
 	{
-		free_str_array(envp);
-		set_child_finished();
+		wait_and_cleanup(data->head, envp);
 		return (1);
 	}
-	return (wait_and_cleanup(envp));
+	return (wait_and_cleanup(data->head, envp));
 }
 
 // ============================ SIGNALS ============================ //
@@ -911,6 +897,7 @@ void default_signals(void)
 {
     signal(SIGINT, SIG_DFL);
     signal(SIGQUIT, SIG_DFL);
+    signal(SIGCHLD, SIG_DFL);
 }
 
 void set_child_running(void)
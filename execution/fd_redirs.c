@@ -0,0 +1,234 @@
+#include "minishell.h"
+
+// Redirections of descriptors other than a plain stdin/stdout file
+// ("2>err", "3>>log", "2>&1", "<&-"). Every source descriptor a command
+// owns is moved to SHELL_FD_BASE or above with close-on-exec set, so no
+// dup2() of one entry can clobber the source of another and none of them
+// leak into the exec'd program. "N>&0" and "N>&1" against an unredirected
+// stdin/stdout are resolved when the command starts, so "2>&1 | cmd"
+// points stderr at the pipe. exec without a command applies everything to
+// the shell itself and keeps it, which is how "exec 3>>log" leaves fd 3
+// open for every later "echo ... >&3".
+
+// Moves fd to SHELL_FD_BASE or above, close-on-exec
+int	move_fd_high(int fd)
+{
+	int	high;
+
+	if (fd < 0 || fd >= SHELL_FD_BASE)
+		return (fd);
+	high = fcntl(fd, F_DUPFD_CLOEXEC, SHELL_FD_BASE);
+	close(fd);
+	return (high);
+}
+
+static void	drop_redir(t_cmd *cmd, int fd)
+{
+	t_redir	**link;
+	t_redir	*redir;
+
+	link = &cmd->redirs;
+	while (*link)
+	{
+		redir = *link;
+		if (redir->fd == fd)
+		{
+			*link = redir->next;
+			if (redir->owned)
+				close(redir->src);
+			free(redir);
+		}
+		else
+			link = &redir->next;
+	}
+}
+
+// Entries that copy the command's stdin/stdout at start must keep the one
+// from before io is redirected: "2>&1 >file" sends stderr to the terminal
+static void	pin_std_sources(t_cmd *cmd, int io)
+{
+	t_redir	*redir;
+
+	redir = cmd->redirs;
+	while (redir)
+	{
+		if (!redir->owned && redir->src == io)
+		{
+			redir->src = fcntl(io, F_DUPFD_CLOEXEC, SHELL_FD_BASE);
+			redir->owned = (redir->src >= 0);
+		}
+		redir = redir->next;
+	}
+}
+
+static int	add_redir(t_cmd *cmd, int io, int src, int owned)
+{
+	t_redir	*redir;
+	t_redir	**link;
+
+	redir = malloc(sizeof(t_redir));
+	if (!redir)
+	{
+		if (owned)
+			close(src);
+		return (0);
+	}
+	redir->fd = io;
+	redir->src = src;
+	redir->owned = owned;
+	redir->saved = -1;
+	redir->next = NULL;
+	link = &cmd->redirs;
+	while (*link)
+		link = &(*link)->next;
+	*link = redir;
+	return (1);
+}
+
+// Makes src the new io of cmd; src -1 closes io. An owned src is closed
+// with the command.
+int	set_cmd_fd(t_cmd *cmd, int io, int src, int owned)
+{
+	if (io <= 1 && owned)
+		pin_std_sources(cmd, io);
+	drop_redir(cmd, io);
+	if (io == 0 && cmd->in_file != STDIN_FILENO)
+		close(cmd->in_file);
+	if (io == 1 && cmd->out_file != STDOUT_FILENO)
+		close(cmd->out_file);
+	if (io == 0)
+		cmd->in_file = STDIN_FILENO;
+	if (io == 1)
+		cmd->out_file = STDOUT_FILENO;
+	if (io == 0 && owned)
+		cmd->in_file = src;
+	else if (io == 1 && owned)
+		cmd->out_file = src;
+	else
+	{
+		if (owned)
+			src = move_fd_high(src);
+		if (owned && src < 0)
+			return (0);
+		return (add_redir(cmd, io, src, owned));
+	}
+	return (1);
+}
+
+// Source for "N>&m": a private copy of what m is for cmd so far, or m
+// itself (not owned) for an unredirected stdin/stdout. -1 if m is closed.
+int	dup_cmd_fd(t_cmd *cmd, int m, int *owned)
+{
+	t_redir	*redir;
+	int		src;
+
+	*owned = 1;
+	src = m;
+	redir = cmd->redirs;
+	while (redir && redir->fd != m)
+		redir = redir->next;
+	if (redir && redir->src < 0)
+		return (-1);
+	if (redir)
+		src = redir->src;
+	else if (m == 0 && cmd->in_file != STDIN_FILENO)
+		src = cmd->in_file;
+	else if (m == 1 && cmd->out_file != STDOUT_FILENO)
+		src = cmd->out_file;
+	if ((redir && !redir->owned) || (!redir && src <= 1))
+	{
+		*owned = 0;
+		return (src);
+	}
+	return (fcntl(src, F_DUPFD_CLOEXEC, SHELL_FD_BASE));
+}
+
+void	free_redirs(t_redir *redir)
+{
+	t_redir	*next;
+
+	while (redir)
+	{
+		next = redir->next;
+		if (redir->owned)
+			close(redir->src);
+		free(redir);
+		redir = next;
+	}
+}
+
+// Applies the entries in order, after stdin/stdout are in place
+void	apply_fd_redirs(t_cmd *cmd)
+{
+	t_redir	*redir;
+
+	redir = cmd->redirs;
+	while (redir)
+	{
+		if (redir->src < 0)
+			close(redir->fd);
+		else if (redir->src != redir->fd)
+			dup2(redir->src, redir->fd);
+		redir = redir->next;
+	}
+}
+
+// Same for a command that runs in the shell: the old descriptors are kept
+// aside for restore_fd_redirs()
+void	save_fd_redirs(t_cmd *cmd)
+{
+	t_redir	*redir;
+
+	fflush(stdout);
+	redir = cmd->redirs;
+	while (redir)
+	{
+		redir->saved = fcntl(redir->fd, F_DUPFD_CLOEXEC, SHELL_FD_BASE);
+		redir = redir->next;
+	}
+	apply_fd_redirs(cmd);
+}
+
+void	restore_fd_redirs(t_cmd *cmd)
+{
+	t_redir	*redir;
+
+	fflush(stdout);
+	redir = cmd->redirs;
+	while (redir)
+	{
+		if (redir->saved >= 0)
+		{
+			dup2(redir->saved, redir->fd);
+			close(redir->saved);
+		}
+		else
+			close(redir->fd);
+		redir->saved = -1;
+		redir = redir->next;
+	}
+}
+
+// exec [command [args]]: with a command the shell is replaced by it,
+// without one the redirections are applied to the shell for good. In a
+// pipeline child (in_shell 0) they are already in place.
+int	builtin_exec(t_cmd *cmd, t_env **env_list, int in_shell)
+{
+	t_cmd	target;
+
+	if (cmd->full_cmd[1])
+	{
+		target = *cmd;
+		target.full_cmd = cmd->full_cmd + 1;
+		return (exec_in_place(&target, env_list));
+	}
+	if (!in_shell)
+		return (0);
+	fflush(stdout);
+	if (cmd->in_file != STDIN_FILENO)
+		dup2(cmd->in_file, STDIN_FILENO);
+	if (cmd->out_file != STDOUT_FILENO)
+		dup2(cmd->out_file, STDOUT_FILENO);
+	apply_fd_redirs(cmd);
+	return (0);
+}
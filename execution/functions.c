@@ -0,0 +1,248 @@
+#include "minishell.h"
+
+// Shell functions. A definition stores its own copy of the parsed body, so
+// the parse cache may drop the line that defined it. A call pushes a frame
+// with the positional parameters and runs the body with execute_list() in
+// the current process; "return" unwinds to the innermost call. A call
+// holds a reference to the body it runs, so a function may redefine
+// itself ("f() { f() { echo inner; }; echo outer; }; f; f") and go on
+// with the old body, which is freed when the call ends.
+
+static t_func	*g_funcs = NULL;
+static t_frame	g_base_frame = {NULL, 0, NULL, NULL};
+static t_frame	*g_frame = &g_base_frame;
+static int		g_returning = 0;
+static int		g_caller_status = 0;
+
+t_node	*find_function(const char *name)
+{
+	t_func	*func;
+
+	func = g_funcs;
+	while (func && ft_strcmp(func->name, name))
+		func = func->next;
+	if (!func)
+		return (NULL);
+	return (func->body->list);
+}
+
+static void	body_release(t_fbody *body)
+{
+	if (!body || --body->refs > 0)
+		return ;
+	free_node_list(body->list);
+	free(body);
+}
+
+// Defines (or redefines) name with a copy of body
+int	define_function(const char *name, t_node *body)
+{
+	t_func	*func;
+	t_fbody	*copy;
+
+	copy = malloc(sizeof(t_fbody));
+	if (!copy)
+		return (1);
+	copy->refs = 1;
+	copy->list = copy_node_list(body);
+	if (!copy->list)
+	{
+		free(copy);
+		return (1);
+	}
+	func = g_funcs;
+	while (func && ft_strcmp(func->name, name))
+		func = func->next;
+	if (func)
+	{
+		body_release(func->body);
+		func->body = copy;
+		return (0);
+	}
+	func = malloc(sizeof(t_func));
+	if (func)
+		func->name = ft_strdup(name);
+	if (!func || !func->name)
+	{
+		free(func);
+		body_release(copy);
+		return (1);
+	}
+	func->body = copy;
+	func->next = g_funcs;
+	g_funcs = func;
+	return (0);
+}
+
+// Positional parameters of the -c command string: $0 is args[0]
+void	set_positional_params(char **args)
+{
+	g_base_frame.args = args;
+	g_base_frame.count = 0;
+	while (args && args[g_base_frame.count])
+		g_base_frame.count++;
+}
+
+t_frame	*current_frame(void)
+{
+	return (g_frame);
+}
+
+static char	*append_word(char *text, const char *word)
+{
+	char	*joined;
+
+	if (!text)
+		return (NULL);
+	joined = ft_strjoin(text, word);
+	free(text);
+	return (joined);
+}
+
+// Value of $0..$9, $# or $@/$* for the innermost frame (allocated); the
+// parameters of $@ and $* are joined with the first character of IFS
+char	*positional_value(const char *name, t_env *env_list)
+{
+	char	*text;
+	char	*ifs;
+	char	sep[2];
+	int		i;
+
+	if (*name == '#')
+		return (ft_itoa(g_frame->count - (g_frame->count > 0)));
+	if (*name == '@' || *name == '*')
+	{
+		ifs = get_env_value(env_list, "IFS");
+		sep[0] = ' ';
+		if (ifs)
+			sep[0] = ifs[0];
+		sep[1] = '\0';
+		text = ft_strdup("");
+		i = 1;
+		while (text && i < g_frame->count)
+		{
+			if (i > 1)
+				text = append_word(text, sep);
+			text = append_word(text, g_frame->args[i++]);
+		}
+		return (text);
+	}
+	i = ft_atoi(name);
+	if (i == 0 && !g_frame->count)
+		return (ft_strdup("minishell"));
+	if (i >= g_frame->count)
+		return (ft_strdup(""));
+	return (ft_strdup(g_frame->args[i]));
+}
+
+// $? inside a function starts out as the status before the call
+void	set_caller_status(int status)
+{
+	g_caller_status = status;
+}
+
+// The definition whose body is list, found just before the call
+static t_fbody	*body_of(t_node *list)
+{
+	t_func	*func;
+
+	func = g_funcs;
+	while (func && func->body->list != list)
+		func = func->next;
+	if (!func)
+		return (NULL);
+	return (func->body);
+}
+
+// Runs the body with args as $0..$N; args[0] is the function name
+int	call_function(t_node *body, char **args, t_env **env_list)
+{
+	t_frame	frame;
+	t_fbody	*held;
+	int		code;
+
+	frame.args = args;
+	frame.count = 0;
+	while (args[frame.count])
+		frame.count++;
+	frame.status = &code;
+	frame.prev = g_frame;
+	g_frame = &frame;
+	code = g_caller_status;
+	held = body_of(body);
+	if (held)
+		held->refs++;
+	execute_list(body, &code, env_list);
+	body_release(held);
+	g_returning = 0;
+	g_frame = frame.prev;
+	return (code);
+}
+
+int	function_returning(void)
+{
+	return (g_returning);
+}
+
+// A function called as a single command: same redirection handling as a
+// builtin, no fork
+int	run_function_command(t_cmd *cmd, t_node *body, t_env **env_list)
+{
+	int	saved_stdin;
+	int	saved_stdout;
+	int	ret;
+
+	saved_stdin = -1;
+	saved_stdout = -1;
+	if (cmd->in_file != STDIN_FILENO)
+	{
+		saved_stdin = dup(STDIN_FILENO);
+		dup2(cmd->in_file, STDIN_FILENO);
+	}
+	if (cmd->out_file != STDOUT_FILENO)
+	{
+		saved_stdout = dup(STDOUT_FILENO);
+		dup2(cmd->out_file, STDOUT_FILENO);
+	}
+	save_fd_redirs(cmd);
+	ret = call_function(body, cmd->full_cmd, env_list);
+	restore_fd_redirs(cmd);
+	if (saved_stdin != -1)
+	{
+		dup2(saved_stdin, STDIN_FILENO);
+		close(saved_stdin);
+	}
+	if (saved_stdout != -1)
+	{
+		dup2(saved_stdout, STDOUT_FILENO);
+		close(saved_stdout);
+	}
+	return (ret);
+}
+
+// return [n]: leaves the innermost function with n, or with $?
+int	builtin_return(char **args)
+{
+	int	i;
+
+	if (g_frame == &g_base_frame)
+	{
+		ft_putstr_fd("minishell: return: can only `return' from a function\n",
+			2);
+		return (1);
+	}
+	g_returning = 1;
+	if (!args[1])
+		return (*g_frame->status);
+	i = 0;
+	if (args[1][i] == '-' || args[1][i] == '+')
+		i++;
+	while (ft_isdigit(args[1][i]))
+		i++;
+	if (args[1][i] || i == 0 || !ft_isdigit(args[1][i - 1]))
+	{
+		ft_putstr_fd("minishell: return: numeric argument required\n", 2);
+		return (2);
+	}
+	return ((unsigned char)ft_atoi(args[1]));
+}
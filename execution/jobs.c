@@ -0,0 +1,449 @@
+#include "minishell.h"
+
+// Background job table. Children are never reaped with a blocking wait():
+// SIGCHLD only writes a byte into a self-pipe, and the main loop (or the
+// wait builtin) polls that pipe and reaps the finished jobs with WNOHANG.
+
+static t_job	*g_jobs = NULL;
+static int		g_chld_pipe[2] = {-1, -1};
+
+static void	sigchld_handler(int signo)
+{
+	int	saved_errno;
+
+	(void)signo;
+	saved_errno = errno;
+	if (g_chld_pipe[1] != -1)
+		write(g_chld_pipe[1], "", 1);
+	errno = saved_errno;
+}
+
+int	init_job_control(void)
+{
+	struct sigaction	sa;
+	int					i;
+
+	if (pipe(g_chld_pipe) < 0)
+		return (0);
+	i = 0;
+	while (i < 2)
+	{
+		g_chld_pipe[i] = move_fd_high(g_chld_pipe[i]);
+		fcntl(g_chld_pipe[i], F_SETFL, O_NONBLOCK);
+		fcntl(g_chld_pipe[i], F_SETFD, FD_CLOEXEC);
+		i++;
+	}
+	ft_memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = sigchld_handler;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	return (sigaction(SIGCHLD, &sa, NULL) == 0);
+}
+
+int	job_event_fd(void)
+{
+	return (g_chld_pipe[0]);
+}
+
+static int	status_to_exit_code(int status)
+{
+	if (WIFSIGNALED(status))
+		return (128 + WTERMSIG(status));
+	if (WIFEXITED(status))
+		return (WEXITSTATUS(status));
+	return (1);
+}
+
+// Drains the self-pipe and collects every job that has finished
+int	reap_jobs(void)
+{
+	char	buf[64];
+	t_job	*job;
+	int		status;
+	int		reaped;
+	pid_t	ret;
+
+	while (g_chld_pipe[0] != -1 && read(g_chld_pipe[0], buf, sizeof(buf)) > 0)
+		;
+	reaped = 0;
+	job = g_jobs;
+	while (job)
+	{
+		ret = 0;
+		if (job->state == JOB_RUNNING)
+			ret = waitpid(job->pid, &status, WNOHANG);
+		if (ret == job->pid || (ret < 0 && errno == ECHILD))
+		{
+			job->status = 127;
+			if (ret == job->pid)
+				job->status = status_to_exit_code(status);
+			job->state = JOB_DONE;
+			reaped++;
+		}
+		job = job->next;
+	}
+	return (reaped);
+}
+
+// Blocks until the next SIGCHLD notification, then reaps
+static void	wait_job_event(void)
+{
+	struct pollfd	pfd;
+
+	pfd.fd = g_chld_pipe[0];
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+		return ;
+	reap_jobs();
+}
+
+static void	remove_job(t_job *job)
+{
+	t_job	**link;
+
+	link = &g_jobs;
+	while (*link && *link != job)
+		link = &(*link)->next;
+	if (*link)
+		*link = job->next;
+	free(job->cmd);
+	free(job);
+}
+
+static char	job_marker(t_job *job)
+{
+	t_job	*last;
+	t_job	*prev;
+
+	last = g_jobs;
+	prev = NULL;
+	while (last && last->next)
+	{
+		prev = last;
+		last = last->next;
+	}
+	if (job == last)
+		return ('+');
+	if (job == prev)
+		return ('-');
+	return (' ');
+}
+
+static void	print_job(t_job *job)
+{
+	char	state[32];
+
+	if (job->state == JOB_RUNNING)
+		ft_strlcpy(state, "Running", sizeof(state));
+	else if (job->status == 0)
+		ft_strlcpy(state, "Done", sizeof(state));
+	else
+		snprintf(state, sizeof(state), "Exit %d", job->status);
+	printf("[%d]%c  %-24s%s%s\n", job->id, job_marker(job), state, job->cmd,
+		job->state == JOB_RUNNING ? " &" : "");
+}
+
+// Prints "[n]+  Done ..." for finished jobs and forgets them
+void	report_jobs(void)
+{
+	t_job	*job;
+	t_job	*next;
+
+	reap_jobs();
+	job = g_jobs;
+	while (job)
+	{
+		next = job->next;
+		if (job->state == JOB_DONE)
+		{
+			print_job(job);
+			remove_job(job);
+		}
+		job = next;
+	}
+	fflush(stdout);
+}
+
+static t_job	*add_job(pid_t pid, char *cmd)
+{
+	t_job	*job;
+	t_job	*last;
+
+	job = malloc(sizeof(t_job));
+	if (!job)
+		return (NULL);
+	job->id = 1;
+	job->pid = pid;
+	job->status = 0;
+	job->state = JOB_RUNNING;
+	job->cmd = cmd;
+	job->next = NULL;
+	if (!g_jobs)
+		g_jobs = job;
+	else
+	{
+		last = g_jobs;
+		while (last->next)
+			last = last->next;
+		job->id = last->id + 1;
+		last->next = job;
+	}
+	return (job);
+}
+
+static char	*append_text(char *text, char *piece)
+{
+	char	*joined;
+
+	joined = NULL;
+	if (text && piece)
+		joined = ft_strjoin(text, piece);
+	free(text);
+	free(piece);
+	return (joined);
+}
+
+static char	*tokens_to_text(char *text, t_elem *token)
+{
+	char	*quote;
+	char	*piece;
+	char	*trimmed;
+
+	piece = ft_strdup("");
+	while (piece && token)
+	{
+		quote = "";
+		if (token->state == IN_QUOTE)
+			quote = "'";
+		else if (token->state == IN_DQUOTE)
+			quote = "\"";
+		piece = append_text(piece, ft_strjoin3(quote, token->content, quote));
+		token = token->next;
+	}
+	trimmed = NULL;
+	if (piece)
+		trimmed = ft_strtrim(piece, " \t");
+	free(piece);
+	return (append_text(text, trimmed));
+}
+
+static char	*list_to_text(char *text, t_node *node, t_node *last);
+
+// Rebuilds the source text of one command, compounds included
+static char	*node_to_text(char *text, t_node *node)
+{
+	if (node->timed == TIME_POSIX)
+		text = append_text(text, ft_strdup("time -p "));
+	else if (node->timed == TIME_VERBOSE)
+		text = append_text(text, ft_strdup("time -v "));
+	else if (node->timed)
+		text = append_text(text, ft_strdup("time "));
+	if (node->kind == NODE_PIPELINE)
+		return (tokens_to_text(text, node->tokens));
+	if (node->kind == NODE_GROUP)
+		return (append_text(list_to_text(append_text(text, ft_strdup("{ ")),
+					node->body, NULL), ft_strdup("; }")));
+	if (node->kind == NODE_FUNCDEF)
+		return (node_to_text(append_text(text, ft_strjoin(node->var,
+						"() ")), node->body));
+	if (node->kind == NODE_FOR)
+	{
+		text = append_text(text, ft_strjoin3("for ", node->var, ""));
+		if (node->has_in)
+			text = tokens_to_text(append_text(text, ft_strdup(" in ")),
+					node->tokens);
+		return (append_text(list_to_text(append_text(text,
+						ft_strdup("; do ")), node->body, NULL),
+				ft_strdup("; done")));
+	}
+	if (node->kind == NODE_IF)
+		text = append_text(text, ft_strdup("if "));
+	else if (node->kind == NODE_WHILE)
+		text = append_text(text, ft_strdup("while "));
+	else
+		text = append_text(text, ft_strdup("until "));
+	text = list_to_text(text, node->cond, NULL);
+	if (node->kind != NODE_IF)
+		return (append_text(list_to_text(append_text(text,
+						ft_strdup("; do ")), node->body, NULL),
+				ft_strdup("; done")));
+	text = list_to_text(append_text(text, ft_strdup("; then ")), node->body,
+			NULL);
+	if (node->alt)
+		text = list_to_text(append_text(text, ft_strdup("; else ")),
+				node->alt, NULL);
+	return (append_text(text, ft_strdup("; fi")));
+}
+
+// Rebuilds the source text of node..last (or the whole list)
+static char	*list_to_text(char *text, t_node *node, t_node *last)
+{
+	while (text && node)
+	{
+		text = node_to_text(text, node);
+		if (node == last || !node->next)
+			break ;
+		if (node->op == OP_AND)
+			text = append_text(text, ft_strdup(" && "));
+		else if (node->op == OP_OR)
+			text = append_text(text, ft_strdup(" || "));
+		else if (node->op == OP_BACKGROUND)
+			text = append_text(text, ft_strdup(" & "));
+		else
+			text = append_text(text, ft_strdup("; "));
+		node = node->next;
+	}
+	return (text);
+}
+
+// Rebuilds the source text of an and-or list for the jobs listing
+static char	*job_text(t_node *first, t_node *last)
+{
+	return (list_to_text(ft_strdup(""), first, last));
+}
+
+static void	run_background_child(t_node *first, t_node *last, int code,
+		t_env **env_list)
+{
+	int	devnull;
+
+	setpgid(0, 0);
+	default_signals();
+	devnull = open("/dev/null", O_RDONLY);
+	if (devnull != -1)
+	{
+		dup2(devnull, STDIN_FILENO);
+		close(devnull);
+	}
+	run_and_or(first, last, &code, env_list);
+	exit(code);
+}
+
+// Forks a subshell for the and-or list and records it in the job table
+int	launch_background_job(t_node *first, t_node *last, int *last_exit_code,
+		t_env **env_list)
+{
+	t_job	*job;
+	char	*text;
+	pid_t	pid;
+
+	text = job_text(first, last);
+	if (!text)
+		return (1);
+	fflush(stdout);
+	pid = shell_fork();
+	if (pid == 0)
+		run_background_child(first, last, *last_exit_code, env_list);
+	if (pid < 0)
+	{
+		perror("minishell: fork");
+		free(text);
+		return (*last_exit_code = 1);
+	}
+	setpgid(pid, pid);
+	job = add_job(pid, text);
+	if (!job)
+		free(text);
+	else if (isatty(STDIN_FILENO))
+		printf("[%d] %d\n", job->id, (int)pid);
+	return (*last_exit_code = 0);
+}
+
+int	builtin_jobs(char **args)
+{
+	t_job	*job;
+	t_job	*next;
+
+	(void)args;
+	reap_jobs();
+	job = g_jobs;
+	while (job)
+	{
+		next = job->next;
+		print_job(job);
+		if (job->state == JOB_DONE)
+			remove_job(job);
+		job = next;
+	}
+	return (0);
+}
+
+static t_job	*find_job(char *spec)
+{
+	t_job	*job;
+	int		num;
+
+	if (!spec || (!ft_isdigit(spec[spec[0] == '%']) && spec[0] != '%'))
+		return (NULL);
+	num = ft_atoi(spec + (spec[0] == '%'));
+	job = g_jobs;
+	while (job)
+	{
+		if ((spec[0] == '%' && job->id == num)
+			|| (spec[0] != '%' && job->pid == num))
+			return (job);
+		job = job->next;
+	}
+	return (NULL);
+}
+
+static int	wait_for_job(t_job *job)
+{
+	int	code;
+
+	reap_jobs();
+	while (job->state == JOB_RUNNING)
+		wait_job_event();
+	code = job->status;
+	remove_job(job);
+	return (code);
+}
+
+// wait -n: the first job to finish, or one that already has
+static int	wait_next_job(void)
+{
+	t_job	*job;
+
+	while (g_jobs)
+	{
+		reap_jobs();
+		job = g_jobs;
+		while (job && job->state != JOB_DONE)
+			job = job->next;
+		if (job)
+			return (wait_for_job(job));
+		wait_job_event();
+	}
+	return (127);
+}
+
+int	builtin_wait(char **args)
+{
+	t_job	*job;
+	int		code;
+	int		i;
+
+	if (args[1] && !ft_strcmp(args[1], "-n"))
+		return (wait_next_job());
+	code = 0;
+	if (!args[1])
+	{
+		while (g_jobs)
+			wait_for_job(g_jobs);
+		return (0);
+	}
+	i = 1;
+	while (args[i])
+	{
+		job = find_job(args[i]);
+		if (!job)
+		{
+			fprintf(stderr, "minishell: wait: %s: no such job\n", args[i]);
+			code = 127;
+		}
+		else
+			code = wait_for_job(job);
+		i++;
+	}
+	return (code);
+}
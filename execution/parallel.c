@@ -0,0 +1,310 @@
+#include "minishell.h"
+
+// parallel [-j N] [-k] [--] [command line ...]
+// Every argument (or, when there is none, every line read from stdin) is a
+// full command line that goes through the normal lexer/parser/executor in
+// its own child. At most N children run at once. The standard output of
+// each job is collected through a pipe and written out in one piece once
+// the job has finished, either as soon as it finishes or, with -k, in
+// input order. Only standard output is grouped: the jobs share the
+// shell's standard error, so their error messages may interleave.
+
+static int	parallel_usage(void)
+{
+	ft_putstr_fd("minishell: parallel: usage: parallel [-j N] [-k] "
+		"[command ...]\n", 2);
+	return (2);
+}
+
+static int	parse_parallel_opts(char **args, int *i, t_parallel *par)
+{
+	char	*val;
+
+	*i = 1;
+	while (args[*i] && args[*i][0] == '-' && args[*i][1])
+	{
+		if (!ft_strcmp(args[*i], "--"))
+		{
+			(*i)++;
+			break ;
+		}
+		if (!ft_strcmp(args[*i], "-k"))
+			par->keep_order = 1;
+		else if (!ft_strncmp(args[*i], "-j", 2))
+		{
+			val = args[*i] + 2;
+			if (!*val)
+				val = args[++(*i)];
+			if (!val || !ft_isdigit(*val) || ft_atoi(val) <= 0)
+				return (0);
+			par->slots = ft_atoi(val);
+		}
+		else
+			return (0);
+		(*i)++;
+	}
+	return (1);
+}
+
+static int	add_parallel_job(t_parallel *par, char *line, int *cap)
+{
+	t_pjob	*grown;
+
+	if (par->count == *cap)
+	{
+		*cap = *cap * 2 + 8;
+		grown = realloc(par->jobs, sizeof(t_pjob) * *cap);
+		if (!grown)
+			return (0);
+		par->jobs = grown;
+	}
+	ft_memset(&par->jobs[par->count], 0, sizeof(t_pjob));
+	par->jobs[par->count].line = line;
+	par->jobs[par->count].fd = -1;
+	par->count++;
+	return (1);
+}
+
+static int	collect_parallel_jobs(char **args, int i, t_parallel *par)
+{
+	char	*line;
+	size_t	len;
+	int		cap;
+
+	cap = 0;
+	while (args[i])
+		if (!add_parallel_job(par, ft_strdup(args[i++]), &cap))
+			return (0);
+	if (par->count)
+		return (1);
+	line = get_next_line(STDIN_FILENO);
+	while (line)
+	{
+		len = ft_strlen(line);
+		if (len && line[len - 1] == '\n')
+			line[len - 1] = '\0';
+		if (!*line)
+			free(line);
+		else if (!add_parallel_job(par, line, &cap))
+			return (free(line), 0);
+		line = get_next_line(STDIN_FILENO);
+	}
+	return (1);
+}
+
+static void	run_parallel_child(t_pjob *job, int pipefd[2], t_env **env_list)
+{
+	int	code;
+
+	default_signals();
+	close(pipefd[0]);
+	dup2(pipefd[1], STDOUT_FILENO);
+	close(pipefd[1]);
+	code = 0;
+	set_tail_exec(1);
+	if (!process_input(job->line, &code, env_list))
+		code = 2;
+	exit(code);
+}
+
+static int	start_parallel_job(t_parallel *par, t_pjob *job, t_env **env_list)
+{
+	int	pipefd[2];
+
+	if (pipe(pipefd) < 0)
+	{
+		perror("minishell: parallel: pipe");
+		return (0);
+	}
+	fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+	fflush(stdout);
+	job->pid = shell_fork();
+	if (job->pid == 0)
+		run_parallel_child(job, pipefd, env_list);
+	close(pipefd[1]);
+	if (job->pid < 0)
+	{
+		perror("minishell: parallel: fork");
+		close(pipefd[0]);
+		return (0);
+	}
+	job->fd = pipefd[0];
+	job->state = PJOB_RUNNING;
+	par->running++;
+	return (1);
+}
+
+static void	flush_parallel_job(t_pjob *job)
+{
+	size_t	off;
+	ssize_t	n;
+
+	off = 0;
+	while (off < job->len)
+	{
+		n = write(STDOUT_FILENO, job->out + off, job->len - off);
+		if (n <= 0)
+			break ;
+		off += n;
+	}
+	free(job->out);
+	job->out = NULL;
+	job->state = PJOB_FLUSHED;
+}
+
+static void	finish_parallel_job(t_parallel *par, t_pjob *job)
+{
+	int	status;
+
+	close(job->fd);
+	job->fd = -1;
+	waitpid(job->pid, &status, 0);
+	if (WIFSIGNALED(status))
+		job->status = 128 + WTERMSIG(status);
+	else if (WIFEXITED(status))
+		job->status = WEXITSTATUS(status);
+	else
+		job->status = 1;
+	if (job->status)
+		par->failed++;
+	job->state = PJOB_DONE;
+	par->running--;
+	if (!par->keep_order)
+		flush_parallel_job(job);
+	while (par->next_flush < par->count
+		&& par->jobs[par->next_flush].state >= PJOB_DONE)
+	{
+		if (par->jobs[par->next_flush].state == PJOB_DONE)
+			flush_parallel_job(&par->jobs[par->next_flush]);
+		par->next_flush++;
+	}
+}
+
+// Drains whatever the job wrote so far, growing its buffer geometrically.
+// When the buffer cannot grow, the job is killed and what it wrote so far
+// is flushed.
+static int	read_parallel_output(t_parallel *par, t_pjob *job)
+{
+	char	*grown;
+	ssize_t	n;
+
+	if (job->cap - job->len < 4096)
+	{
+		grown = realloc(job->out, job->cap * 2 + 4096);
+		if (!grown)
+		{
+			kill(job->pid, SIGKILL);
+			finish_parallel_job(par, job);
+			return (0);
+		}
+		job->cap = job->cap * 2 + 4096;
+		job->out = grown;
+	}
+	n = read(job->fd, job->out + job->len, job->cap - job->len);
+	if (n < 0 && errno == EINTR)
+		return (1);
+	if (n <= 0)
+		finish_parallel_job(par, job);
+	else
+		job->len += n;
+	return (1);
+}
+
+static int	poll_parallel_jobs(t_parallel *par, struct pollfd *pfds, int *map)
+{
+	int	i;
+	int	n;
+
+	n = 0;
+	i = par->next_flush;
+	while (i < par->next_start)
+	{
+		if (par->jobs[i].state == PJOB_RUNNING)
+		{
+			pfds[n].fd = par->jobs[i].fd;
+			pfds[n].events = POLLIN;
+			map[n++] = i;
+		}
+		i++;
+	}
+	if (poll(pfds, n, -1) < 0)
+		return (errno == EINTR);
+	i = 0;
+	while (i < n)
+	{
+		if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR))
+			if (!read_parallel_output(par, &par->jobs[map[i]]))
+				return (0);
+		i++;
+	}
+	return (1);
+}
+
+static int	run_parallel_jobs(t_parallel *par, t_env **env_list)
+{
+	struct pollfd	*pfds;
+	int				*map;
+	int				ok;
+
+	pfds = malloc(sizeof(struct pollfd) * par->slots);
+	map = malloc(sizeof(int) * par->slots);
+	ok = (pfds && map);
+	while (ok && par->next_flush < par->count)
+	{
+		while (ok && par->running < par->slots && par->next_start < par->count)
+			ok = start_parallel_job(par, &par->jobs[par->next_start++],
+					env_list);
+		if (ok && par->running)
+			ok = poll_parallel_jobs(par, pfds, map);
+	}
+	while (par->running)
+		poll_parallel_jobs(par, pfds, map);
+	free(pfds);
+	free(map);
+	return (ok);
+}
+
+static void	free_parallel(t_parallel *par)
+{
+	int	i;
+
+	i = 0;
+	while (i < par->count)
+	{
+		free(par->jobs[i].line);
+		free(par->jobs[i].out);
+		i++;
+	}
+	free(par->jobs);
+}
+
+// Exit status follows GNU parallel: the number of failed jobs, capped at 101
+int	builtin_parallel(char **args, t_env **env_list)
+{
+	t_parallel	par;
+	int			i;
+	int			ret;
+
+	ft_memset(&par, 0, sizeof(t_parallel));
+	par.slots = sysconf(_SC_NPROCESSORS_ONLN);
+	if (par.slots <= 0)
+		par.slots = 1;
+	if (!parse_parallel_opts(args, &i, &par))
+		return (parallel_usage());
+	if (!collect_parallel_jobs(args, i, &par))
+	{
+		free_parallel(&par);
+		return (1);
+	}
+	set_child_running();
+	ret = run_parallel_jobs(&par, env_list);
+	set_child_finished();
+	if (!ret)
+		ret = 1;
+	else if (par.failed > 101)
+		ret = 101;
+	else
+		ret = par.failed;
+	free_parallel(&par);
+	return (ret);
+}
@@ -0,0 +1,107 @@
+#include "minishell.h"
+
+// Remembers where each command was found in PATH, like the hash table of
+// other shells. The whole table is dropped when PATH changes. A hit is
+// checked with a single access() before it is used, so a binary that went
+// away is looked up again instead of failing. The shell primes the table
+// before it forks, so the child, which does the actual lookup, inherits
+// the entry.
+
+static t_pathent	*g_path_table[PATH_CACHE_SIZE];
+static char			*g_path_value = NULL;
+
+static unsigned long	hash_name(const char *s)
+{
+	unsigned long	h;
+
+	h = 5381;
+	while (*s)
+		h = h * 33 + (unsigned char)*s++;
+	return (h % PATH_CACHE_SIZE);
+}
+
+void	path_cache_clear(void)
+{
+	t_pathent	*ent;
+	t_pathent	*next;
+	int			i;
+
+	i = 0;
+	while (i < PATH_CACHE_SIZE)
+	{
+		ent = g_path_table[i];
+		while (ent)
+		{
+			next = ent->next;
+			free(ent->name);
+			free(ent->path);
+			free(ent);
+			ent = next;
+		}
+		g_path_table[i++] = NULL;
+	}
+	free(g_path_value);
+	g_path_value = NULL;
+}
+
+static t_pathent	**find_slot(const char *name, const char *path_value)
+{
+	t_pathent	**link;
+
+	if (!g_path_value || ft_strcmp(g_path_value, path_value))
+	{
+		path_cache_clear();
+		g_path_value = ft_strdup(path_value);
+	}
+	link = &g_path_table[hash_name(name)];
+	while (*link && ft_strcmp((*link)->name, name))
+		link = &(*link)->next;
+	return (link);
+}
+
+// Cached full path of name (allocated), or NULL. With verify the entry
+// is dropped if it is no longer executable.
+char	*path_cache_find(const char *name, const char *path_value, int verify)
+{
+	t_pathent	**link;
+	t_pathent	*ent;
+
+	link = find_slot(name, path_value);
+	ent = *link;
+	if (!ent)
+		return (NULL);
+	if (verify && access(ent->path, X_OK) != 0)
+	{
+		*link = ent->next;
+		free(ent->name);
+		free(ent->path);
+		free(ent);
+		return (NULL);
+	}
+	return (ft_strdup(ent->path));
+}
+
+void	path_cache_add(const char *name, const char *path_value,
+		const char *path)
+{
+	t_pathent	**link;
+	t_pathent	*ent;
+
+	link = find_slot(name, path_value);
+	if (*link || !g_path_value)
+		return ;
+	ent = malloc(sizeof(t_pathent));
+	if (!ent)
+		return ;
+	ent->name = ft_strdup(name);
+	ent->path = ft_strdup(path);
+	ent->next = NULL;
+	if (!ent->name || !ent->path)
+	{
+		free(ent->name);
+		free(ent->path);
+		free(ent);
+		return ;
+	}
+	*link = ent;
+}
@@ -0,0 +1,139 @@
+#include "minishell.h"
+
+// <( list ) and >( list ): the list runs in a child connected to a pipe and
+// the word becomes /dev/fd/N for the shell's end of it. That end stays open
+// (no close-on-exec) so the command exec'd by the pipeline inherits it. The
+// pipeline that expanded the word reaps its substitutions when it is done:
+// every shell-side end is closed first, which gives a >( ) reader its EOF
+// and a <( ) writer nobody left to write to, then the children are waited.
+
+static t_psub	*g_psubs = NULL;
+static int		g_psub_count = 0;
+
+// Closes the shell-side ends of all open substitutions (in a new child)
+static void	close_proc_subst_fds(void)
+{
+	t_psub	*psub;
+
+	psub = g_psubs;
+	while (psub)
+	{
+		close(psub->fd);
+		psub = psub->next;
+	}
+}
+
+static int	register_proc_subst(pid_t pid, int fd)
+{
+	t_psub	*psub;
+
+	psub = malloc(sizeof(t_psub));
+	if (!psub)
+		return (0);
+	psub->pid = pid;
+	psub->fd = fd;
+	psub->next = g_psubs;
+	g_psubs = psub;
+	g_psub_count++;
+	return (1);
+}
+
+// The child keeps fds[1] as stdout for <( ), fds[0] as stdin for >( )
+static pid_t	spawn_proc_subst(t_node *list, int fds[2], char dir,
+		int exit_code, t_env **env_list)
+{
+	pid_t	pid;
+
+	fflush(stdout);
+	pid = shell_fork();
+	if (pid == 0)
+	{
+		default_signals();
+		close_proc_subst_fds();
+		close(fds[dir == '>']);
+		dup2(fds[dir == '<'], dir == '<');
+		close(fds[dir == '<']);
+		set_tail_exec(1);
+		execute_list(list, &exit_code, env_list);
+		fflush(stdout);
+		exit(exit_code);
+	}
+	if (pid < 0)
+		perror("fork");
+	return (pid);
+}
+
+// Starts text with its stdout (<) or stdin (>) on a pipe; returns the
+// /dev/fd path of the other end. An empty list gets a pipe with no peer.
+char	*process_substitution(char dir, char *text, int exit_code,
+		t_env *env_list)
+{
+	t_node	*list;
+	int		cached;
+	int		error;
+	int		fds[2];
+	pid_t	pid;
+	char	*num;
+	char	*path;
+
+	list = parse_cache_lookup(text, &cached, &error);
+	if (error)
+		return (NULL);
+	pid = -1;
+	if (pipe(fds) == 0)
+	{
+		pid = 0;
+		if (list)
+			pid = spawn_proc_subst(list, fds, dir, exit_code, &env_list);
+		close(fds[dir == '<']);
+		if (pid < 0 || !register_proc_subst(pid, fds[dir == '>']))
+		{
+			close(fds[dir == '>']);
+			pid = -1;
+		}
+	}
+	if (list && cached)
+		parse_cache_release(list);
+	else if (list)
+		free_node_list(list);
+	if (pid < 0)
+		return (NULL);
+	num = ft_itoa(fds[dir == '>']);
+	path = NULL;
+	if (num)
+		path = ft_strjoin("/dev/fd/", num);
+	free(num);
+	return (path);
+}
+
+int	proc_subst_mark(void)
+{
+	return (g_psub_count);
+}
+
+// Closes and waits for the substitutions started since mark
+void	reap_proc_substs(int mark)
+{
+	t_psub	*psub;
+	t_psub	*next;
+	int		n;
+
+	psub = g_psubs;
+	n = g_psub_count;
+	while (psub && n-- > mark)
+	{
+		close(psub->fd);
+		psub = psub->next;
+	}
+	set_child_running();
+	while (g_psubs && g_psub_count > mark)
+	{
+		next = g_psubs->next;
+		if (g_psubs->pid > 0)
+			wait_child(g_psubs->pid, NULL);
+		free(g_psubs);
+		g_psubs = next;
+		g_psub_count--;
+	}
+	set_child_finished();
+}
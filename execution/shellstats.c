@@ -0,0 +1,158 @@
+#include "minishell.h"
+#include <sys/mman.h>
+#include <malloc.h>
+
+// Session counters for the shellstats builtin. They live in a MAP_SHARED
+// page created before the first fork, so children (which do the PATH
+// lookups and the exec) count into the same place as the shell; updates
+// are atomic because pipeline stages run at the same time. Latencies go
+// into log2 histograms: bucket i counts values in [2^i, 2^(i+1)) us.
+
+static t_stats	g_fallback;
+static t_stats	*g_stats = NULL;
+static long		g_spawn_start = 0;
+
+static t_stats	*stats(void)
+{
+	void	*page;
+
+	if (g_stats)
+		return (g_stats);
+	page = mmap(NULL, sizeof(t_stats), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	g_stats = &g_fallback;
+	if (page != MAP_FAILED)
+		g_stats = page;
+	return (g_stats);
+}
+
+long	now_usec(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000000L + ts.tv_nsec / 1000);
+}
+
+void	stats_count(enum e_stat which, unsigned long n)
+{
+	__atomic_add_fetch(&stats()->count[which], n, __ATOMIC_RELAXED);
+}
+
+void	stats_latency(enum e_hist which, long usec)
+{
+	int	bucket;
+
+	bucket = 0;
+	while (usec > 1 && bucket < STATS_BUCKETS - 1)
+	{
+		usec >>= 1;
+		bucket++;
+	}
+	__atomic_add_fetch(&stats()->hist[which][bucket], 1, __ATOMIC_RELAXED);
+}
+
+// fork() that counts the spawn and lets the child time how long it takes
+// to reach execve()
+pid_t	shell_fork(void)
+{
+	pid_t	pid;
+
+	stats_count(STAT_FORKS, 1);
+	g_spawn_start = now_usec();
+	pid = fork();
+	if (pid != 0)
+		g_spawn_start = 0;
+	return (pid);
+}
+
+// Called right before execve()
+void	stats_exec(void)
+{
+	stats_count(STAT_EXECS, 1);
+	if (g_spawn_start)
+		stats_latency(HIST_SPAWN, now_usec() - g_spawn_start);
+	g_spawn_start = 0;
+}
+
+static void	print_histogram(const char *title, unsigned long *hist, int json)
+{
+	int	i;
+	int	first;
+
+	if (json)
+		printf(", \"%s\": {", title);
+	else
+		printf("\n%s\n", title);
+	first = 1;
+	i = -1;
+	while (++i < STATS_BUCKETS)
+	{
+		if (!hist[i])
+			continue ;
+		if (json)
+			printf("%s\"%lu\": %lu", first ? "" : ", ", 1UL << i, hist[i]);
+		else
+			printf("  %10lu+ us  %lu\n", (1UL << i) * (i > 0), hist[i]);
+		first = 0;
+	}
+	if (json)
+		printf("}");
+}
+
+static void	print_stats(t_stats *st, int json)
+{
+	static const char	*names[STAT_COUNT] = {"lines", "lines_parsed",
+		"commands", "forks", "execs", "path_lookups", "path_hits",
+		"env_rebuilds", "tilde_lookups", "tilde_hits"};
+	int					i;
+
+	i = -1;
+	if (json)
+		printf("{");
+	while (++i < STAT_COUNT)
+	{
+		if (json)
+			printf("%s\"%s\": %lu", i ? ", " : "", names[i], st->count[i]);
+		else
+			printf("%-14s %lu\n", names[i], st->count[i]);
+	}
+	if (json)
+		printf(", \"heap_in_use\": %zu", mallinfo2().uordblks);
+	else
+		printf("%-14s %zu bytes\n", "heap_in_use", mallinfo2().uordblks);
+	print_histogram("spawn_to_exec_us", st->hist[HIST_SPAWN], json);
+	print_histogram("parse_us", st->hist[HIST_PARSE], json);
+	if (json)
+		printf("}\n");
+}
+
+// shellstats [-j] [-r]: session counters, as text or JSON; -r resets them
+int	builtin_shellstats(char **args)
+{
+	int	json;
+	int	reset;
+	int	i;
+
+	json = 0;
+	reset = 0;
+	i = 0;
+	while (args[++i])
+	{
+		if (!ft_strcmp(args[i], "-j") || !ft_strcmp(args[i], "--json"))
+			json = 1;
+		else if (!ft_strcmp(args[i], "-r"))
+			reset = 1;
+		else
+		{
+			ft_putstr_fd("minishell: shellstats: usage: shellstats [-j] "
+				"[-r]\n", 2);
+			return (2);
+		}
+	}
+	if (reset)
+		ft_memset(stats(), 0, sizeof(t_stats));
+	else
+		print_stats(stats(), json);
+	return (0);
+}
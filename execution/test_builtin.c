@@ -0,0 +1,324 @@
+#include "minishell.h"
+
+// test, [ and [[ evaluated in the shell process. The grammar is the usual
+// one: expr := and { OR and }, and := not { AND not }, not := ! not |
+// primary. test and [ use -a/-o, [[ uses &&/|| and adds <, >, pattern
+// matching for ==/!= and =~. A binary operator in second position always
+// wins, so "[ ! = x ]" compares two strings like POSIX asks.
+
+static int	is_unary_op(const char *s)
+{
+	return (s[0] == '-' && s[1] && !s[2] && ft_strchr("bcdefghknprsStuwxzGLO",
+			s[1]));
+}
+
+static int	is_binary_op(t_test *t, const char *s)
+{
+	if (!ft_strcmp(s, "=") || !ft_strcmp(s, "==") || !ft_strcmp(s, "!=")
+		|| !ft_strcmp(s, "-eq") || !ft_strcmp(s, "-ne")
+		|| !ft_strcmp(s, "-lt") || !ft_strcmp(s, "-le")
+		|| !ft_strcmp(s, "-gt") || !ft_strcmp(s, "-ge")
+		|| !ft_strcmp(s, "-nt") || !ft_strcmp(s, "-ot")
+		|| !ft_strcmp(s, "-ef"))
+		return (1);
+	return (t->extended && (!ft_strcmp(s, "<") || !ft_strcmp(s, ">")
+			|| !ft_strcmp(s, "=~")));
+}
+
+static int	test_error(t_test *t, const char *msg, const char *arg)
+{
+	if (!t->error)
+	{
+		ft_putstr_fd("minishell: ", 2);
+		ft_putstr_fd(t->name, 2);
+		ft_putstr_fd(": ", 2);
+		if (arg)
+		{
+			ft_putstr_fd((char *)arg, 2);
+			ft_putstr_fd(": ", 2);
+		}
+		ft_putstr_fd((char *)msg, 2);
+		ft_putstr_fd("\n", 2);
+	}
+	t->error = 1;
+	return (0);
+}
+
+static int	parse_integer(t_test *t, const char *s, long long *out)
+{
+	const char			*start;
+	int					neg;
+	int					digits;
+	unsigned long long	val;
+
+	start = s;
+	while (*s == ' ' || *s == '\t')
+		s++;
+	neg = (*s == '-');
+	if (*s == '-' || *s == '+')
+		s++;
+	val = 0;
+	digits = 0;
+	while (ft_isdigit(*s) && val <= (unsigned long long)LLONG_MAX / 10 + 1)
+	{
+		val = val * 10 + (*s++ - '0');
+		digits++;
+	}
+	while (*s == ' ' || *s == '\t')
+		s++;
+	if (*s || !digits || val > (unsigned long long)LLONG_MAX + neg)
+		return (test_error(t, "integer expression expected", start));
+	*out = (long long)val;
+	if (neg)
+		*out = -(long long)val;
+	return (1);
+}
+
+// r/w/x from the same stat buffer instead of a second access() call
+static int	has_permission(struct stat *st, mode_t usr, mode_t grp, mode_t oth)
+{
+	gid_t	groups[64];
+	int		n;
+
+	if (geteuid() == 0)
+		return (usr != S_IXUSR || (st->st_mode & (S_IXUSR | S_IXGRP | S_IXOTH))
+			|| S_ISDIR(st->st_mode));
+	if (st->st_uid == geteuid())
+		return ((st->st_mode & usr) != 0);
+	if (st->st_gid == getegid())
+		return ((st->st_mode & grp) != 0);
+	n = getgroups(64, groups);
+	while (n-- > 0)
+		if (groups[n] == st->st_gid)
+			return ((st->st_mode & grp) != 0);
+	return ((st->st_mode & oth) != 0);
+}
+
+static int	file_test(char op, const char *path)
+{
+	struct stat	st;
+
+	if ((op == 'L' || op == 'h') && lstat(path, &st) == 0)
+		return (S_ISLNK(st.st_mode));
+	if (op == 'L' || op == 'h' || stat(path, &st) != 0)
+		return (0);
+	if (op == 'e')
+		return (1);
+	if (op == 'f')
+		return (S_ISREG(st.st_mode));
+	if (op == 'd')
+		return (S_ISDIR(st.st_mode));
+	if (op == 'b')
+		return (S_ISBLK(st.st_mode));
+	if (op == 'c')
+		return (S_ISCHR(st.st_mode));
+	if (op == 'p')
+		return (S_ISFIFO(st.st_mode));
+	if (op == 'S')
+		return (S_ISSOCK(st.st_mode));
+	if (op == 's')
+		return (st.st_size > 0);
+	if (op == 'u' || op == 'g' || op == 'k')
+		return ((op == 'u' && (st.st_mode & S_ISUID))
+			|| (op == 'g' && (st.st_mode & S_ISGID))
+			|| (op == 'k' && (st.st_mode & S_ISVTX)));
+	if (op == 'O' || op == 'G')
+		return ((op == 'O' && st.st_uid == geteuid())
+			|| (op == 'G' && st.st_gid == getegid()));
+	if (op == 'r')
+		return (has_permission(&st, S_IRUSR, S_IRGRP, S_IROTH));
+	if (op == 'w')
+		return (has_permission(&st, S_IWUSR, S_IWGRP, S_IWOTH));
+	return (has_permission(&st, S_IXUSR, S_IXGRP, S_IXOTH));
+}
+
+static int	unary_test(t_test *t, const char *op, const char *arg)
+{
+	long long	fd;
+
+	if (op[1] == 'z')
+		return (arg[0] == '\0');
+	if (op[1] == 'n')
+		return (arg[0] != '\0');
+	if (op[1] == 't')
+		return (parse_integer(t, arg, &fd) && fd >= 0 && fd <= INT_MAX
+			&& isatty((int)fd));
+	return (file_test(op[1], arg));
+}
+
+static int	file_compare(const char *op, const char *a, const char *b)
+{
+	struct stat	sa;
+	struct stat	sb;
+	int			ha;
+	int			hb;
+
+	ha = (stat(a, &sa) == 0);
+	hb = (stat(b, &sb) == 0);
+	if (!ft_strcmp(op, "-ef"))
+		return (ha && hb && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino);
+	if (!ft_strcmp(op, "-ot"))
+		return ((!ha && hb) || (ha && hb && (sa.st_mtim.tv_sec
+					< sb.st_mtim.tv_sec || (sa.st_mtim.tv_sec
+						== sb.st_mtim.tv_sec && sa.st_mtim.tv_nsec
+						< sb.st_mtim.tv_nsec))));
+	return (file_compare("-ot", b, a));
+}
+
+static int	regex_test(t_test *t, const char *s, const char *pattern)
+{
+	regex_t	re;
+	int		match;
+
+	if (regcomp(&re, pattern, REG_EXTENDED | REG_NOSUB) != 0)
+		return (test_error(t, "invalid regular expression", pattern));
+	match = (regexec(&re, s, 0, NULL, 0) == 0);
+	regfree(&re);
+	return (match);
+}
+
+static int	binary_test(t_test *t, const char *a, const char *op, const char *b)
+{
+	long long	x;
+	long long	y;
+
+	if (!ft_strcmp(op, "=") || !ft_strcmp(op, "=="))
+	{
+		if (t->extended)
+			return (fnmatch(b, a, 0) == 0);
+		return (!ft_strcmp(a, b));
+	}
+	if (!ft_strcmp(op, "!="))
+		return ((t->extended && fnmatch(b, a, 0) != 0)
+			|| (!t->extended && ft_strcmp(a, b)));
+	if (!ft_strcmp(op, "<") || !ft_strcmp(op, ">"))
+		return ((op[0] == '<' && ft_strcmp(a, b) < 0)
+			|| (op[0] == '>' && ft_strcmp(a, b) > 0));
+	if (!ft_strcmp(op, "=~"))
+		return (regex_test(t, a, b));
+	if (!ft_strcmp(op, "-nt") || !ft_strcmp(op, "-ot")
+		|| !ft_strcmp(op, "-ef"))
+		return (file_compare(op, a, b));
+	if (!parse_integer(t, a, &x) || !parse_integer(t, b, &y))
+		return (0);
+	if (op[1] == 'e')
+		return (x == y);
+	if (op[1] == 'n')
+		return (x != y);
+	if (op[1] == 'l')
+		return ((op[2] == 't' && x < y) || (op[2] == 'e' && x <= y));
+	return ((op[2] == 't' && x > y) || (op[2] == 'e' && x >= y));
+}
+
+static int	test_or(t_test *t);
+
+static int	test_primary(t_test *t)
+{
+	char	**a;
+	int		val;
+
+	a = t->args + t->pos;
+	if (t->pos >= t->count)
+		return (test_error(t, "argument expected", NULL));
+	if (t->pos + 2 < t->count && is_binary_op(t, a[1]))
+	{
+		t->pos += 3;
+		return (binary_test(t, a[0], a[1], a[2]));
+	}
+	if (!ft_strcmp(a[0], "(") && t->pos + 1 < t->count)
+	{
+		t->pos++;
+		val = test_or(t);
+		if (t->pos >= t->count || ft_strcmp(t->args[t->pos], ")"))
+			return (test_error(t, "`)' expected", NULL));
+		t->pos++;
+		return (val);
+	}
+	if (is_unary_op(a[0]) && t->pos + 1 < t->count)
+	{
+		t->pos += 2;
+		return (unary_test(t, a[0], a[1]));
+	}
+	t->pos++;
+	return (a[0][0] != '\0');
+}
+
+static int	test_not(t_test *t)
+{
+	if (t->pos + 1 < t->count && !ft_strcmp(t->args[t->pos], "!")
+		&& !(t->pos + 2 < t->count && is_binary_op(t, t->args[t->pos + 1])))
+	{
+		t->pos++;
+		return (!test_not(t));
+	}
+	return (test_primary(t));
+}
+
+static int	test_and(t_test *t)
+{
+	int			val;
+	const char	*op;
+
+	op = "-a";
+	if (t->extended)
+		op = "&&";
+	val = test_not(t);
+	while (!t->error && t->pos < t->count && !ft_strcmp(t->args[t->pos], op))
+	{
+		t->pos++;
+		val = test_not(t) && val;
+	}
+	return (val);
+}
+
+static int	test_or(t_test *t)
+{
+	int			val;
+	const char	*op;
+
+	op = "-o";
+	if (t->extended)
+		op = "||";
+	val = test_and(t);
+	while (!t->error && t->pos < t->count && !ft_strcmp(t->args[t->pos], op))
+	{
+		t->pos++;
+		val = test_and(t) || val;
+	}
+	return (val);
+}
+
+// test expr, [ expr ], [[ expr ]]: 0 if true, 1 if false, 2 on error
+int	builtin_test(char **args)
+{
+	t_test		t;
+	int			val;
+	const char	*close;
+
+	ft_memset(&t, 0, sizeof(t_test));
+	t.name = args[0];
+	t.args = args + 1;
+	while (t.args[t.count])
+		t.count++;
+	t.extended = !ft_strcmp(args[0], "[[");
+	if (ft_strcmp(args[0], "test"))
+	{
+		close = "]";
+		if (t.extended)
+			close = "]]";
+		if (!t.count || ft_strcmp(t.args[t.count - 1], close))
+		{
+			test_error(&t, "missing closing bracket", NULL);
+			return (2);
+		}
+		t.count--;
+	}
+	if (!t.count)
+		return (1);
+	val = test_or(&t);
+	if (!t.error && t.pos < t.count)
+		test_error(&t, "too many arguments", NULL);
+	if (t.error)
+		return (2);
+	return (!val);
+}
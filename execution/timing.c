@@ -0,0 +1,161 @@
+#include "minishell.h"
+
+// time [-p|-v] command and the times builtin. Every child the shell waits
+// for in the foreground goes through wait_child(), which uses wait4() and
+// adds the child's rusage to g_waited. A timed command reports the wall
+// clock from CLOCK_MONOTONIC and, for user/sys and the -v counters, the
+// shell's own usage plus everything waited for while it ran, so all the
+// stages of a pipeline, $( ) and <( ) children included, are counted.
+
+static struct rusage	g_waited;
+
+static void	add_usage(struct rusage *sum, struct rusage *ru)
+{
+	sum->ru_utime.tv_sec += ru->ru_utime.tv_sec;
+	sum->ru_utime.tv_usec += ru->ru_utime.tv_usec;
+	sum->ru_stime.tv_sec += ru->ru_stime.tv_sec;
+	sum->ru_stime.tv_usec += ru->ru_stime.tv_usec;
+	sum->ru_minflt += ru->ru_minflt;
+	sum->ru_majflt += ru->ru_majflt;
+	sum->ru_nvcsw += ru->ru_nvcsw;
+	sum->ru_nivcsw += ru->ru_nivcsw;
+	sum->ru_inblock += ru->ru_inblock;
+	sum->ru_oublock += ru->ru_oublock;
+	if (ru->ru_maxrss > sum->ru_maxrss)
+		sum->ru_maxrss = ru->ru_maxrss;
+}
+
+// waitpid() for foreground children, keeping their resource usage
+pid_t	wait_child(pid_t pid, int *status)
+{
+	struct rusage	ru;
+	pid_t			ret;
+
+	ret = wait4(pid, status, 0, &ru);
+	if (ret > 0)
+		add_usage(&g_waited, &ru);
+	return (ret);
+}
+
+static long	usec_of(struct timeval tv)
+{
+	return (tv.tv_sec * 1000000L + tv.tv_usec);
+}
+
+// "1m2.345s"
+static void	put_duration(FILE *out, long usec)
+{
+	fprintf(out, "%ldm%ld.%03lds", usec / 60000000, usec / 1000000 % 60,
+		usec % 1000000 / 1000);
+}
+
+// "real\t0m1.234s", or "real 1.23" for -p
+static void	report_line(const char *label, long usec, enum e_time_mode mode)
+{
+	if (mode == TIME_POSIX)
+	{
+		fprintf(stderr, "%s %ld.%02ld\n", label, usec / 1000000,
+			usec % 1000000 / 10000);
+		return ;
+	}
+	fprintf(stderr, "%s\t", label);
+	put_duration(stderr, usec);
+	fprintf(stderr, "\n");
+}
+
+static void	report_time(long real, struct rusage *self, struct rusage *kids,
+		enum e_time_mode mode)
+{
+	if (mode != TIME_POSIX)
+		fprintf(stderr, "\n");
+	report_line("real", real, mode);
+	report_line("user", usec_of(self->ru_utime) + usec_of(kids->ru_utime),
+		mode);
+	report_line("sys", usec_of(self->ru_stime) + usec_of(kids->ru_stime),
+		mode);
+	if (mode != TIME_VERBOSE)
+		return ;
+	fprintf(stderr, "faults\t%ld major, %ld minor\n",
+		self->ru_majflt + kids->ru_majflt, self->ru_minflt + kids->ru_minflt);
+	fprintf(stderr, "ctxsw\t%ld voluntary, %ld involuntary\n",
+		self->ru_nvcsw + kids->ru_nvcsw, self->ru_nivcsw + kids->ru_nivcsw);
+	fprintf(stderr, "blocks\t%ld in, %ld out\n",
+		self->ru_inblock + kids->ru_inblock,
+		self->ru_oublock + kids->ru_oublock);
+	fprintf(stderr, "maxrss\t%ld KB\n", kids->ru_maxrss);
+}
+
+// b - a, field by field; maxrss is left as it is in b
+static void	usage_delta(struct rusage *b, struct rusage *a)
+{
+	b->ru_utime.tv_sec -= a->ru_utime.tv_sec;
+	b->ru_utime.tv_usec -= a->ru_utime.tv_usec;
+	b->ru_stime.tv_sec -= a->ru_stime.tv_sec;
+	b->ru_stime.tv_usec -= a->ru_stime.tv_usec;
+	b->ru_minflt -= a->ru_minflt;
+	b->ru_majflt -= a->ru_majflt;
+	b->ru_nvcsw -= a->ru_nvcsw;
+	b->ru_nivcsw -= a->ru_nivcsw;
+	b->ru_inblock -= a->ru_inblock;
+	b->ru_oublock -= a->ru_oublock;
+}
+
+// CPU time used so far by the shell and the children it has waited for
+long	shell_cpu_usec(void)
+{
+	struct rusage	self;
+
+	getrusage(RUSAGE_SELF, &self);
+	return (usec_of(self.ru_utime) + usec_of(self.ru_stime)
+		+ usec_of(g_waited.ru_utime) + usec_of(g_waited.ru_stime));
+}
+
+// Runs node (never as a tail call) and reports how long it took. maxrss
+// is the largest child waited for meanwhile.
+int	time_command(t_node *node, int *last_exit_code, t_env **env_list)
+{
+	struct timespec	start;
+	struct timespec	end;
+	struct rusage	self_before;
+	struct rusage	self;
+	struct rusage	kids_before;
+	struct rusage	kids;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	getrusage(RUSAGE_SELF, &self_before);
+	kids_before = g_waited;
+	g_waited.ru_maxrss = 0;
+	run_command_node(node, 0, last_exit_code, env_list);
+	getrusage(RUSAGE_SELF, &self);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	usage_delta(&self, &self_before);
+	kids = g_waited;
+	usage_delta(&kids, &kids_before);
+	if (kids_before.ru_maxrss > g_waited.ru_maxrss)
+		g_waited.ru_maxrss = kids_before.ru_maxrss;
+	fflush(stdout);
+	report_time((end.tv_sec - start.tv_sec) * 1000000L
+		+ (end.tv_nsec - start.tv_nsec) / 1000, &self, &kids, node->timed);
+	return (*last_exit_code);
+}
+
+// times: user and sys time of the shell, then of its children
+int	builtin_times(void)
+{
+	struct rusage	ru;
+	int				who;
+
+	who = RUSAGE_SELF;
+	while (1)
+	{
+		getrusage(who, &ru);
+		put_duration(stdout, usec_of(ru.ru_utime));
+		printf(" ");
+		put_duration(stdout, usec_of(ru.ru_stime));
+		printf("\n");
+		if (who == RUSAGE_CHILDREN)
+			break ;
+		who = RUSAGE_CHILDREN;
+	}
+	return (0);
+}
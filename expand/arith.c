@@ -0,0 +1,538 @@
+#include "minishell.h"
+
+// $(( expr )): 64-bit signed integer arithmetic with the C operator set
+// (plus ** for powers), evaluated by precedence climbing straight off the
+// expression text. Variables are read from and assigned to the env list;
+// an unset or empty variable is 0 and a variable holding an expression is
+// evaluated in turn. Overflow wraps like two's complement. With skip set
+// (the untaken side of && || ?:) nothing is assigned and nothing can fail.
+
+static long long	arith_comma(t_arith *a);
+static long long	arith_assign(t_arith *a);
+static long long	arith_unary(t_arith *a);
+
+static int	arith_error(t_arith *a, const char *msg)
+{
+	if (!a->error && !a->skip)
+	{
+		ft_putstr_fd("minishell: ", 2);
+		ft_putstr_fd((char *)a->expr, 2);
+		ft_putstr_fd(": ", 2);
+		ft_putstr_fd((char *)msg, 2);
+		ft_putstr_fd("\n", 2);
+	}
+	if (!a->skip)
+		a->error = 1;
+	return (0);
+}
+
+static void	skip_spaces(t_arith *a)
+{
+	while (a->s[a->pos] == ' ' || a->s[a->pos] == '\t'
+		|| a->s[a->pos] == '\n')
+		a->pos++;
+}
+
+// Consumes op if it is next and not the start of a longer operator
+static int	accept(t_arith *a, const char *op, const char *not_followed)
+{
+	size_t	len;
+
+	skip_spaces(a);
+	len = ft_strlen(op);
+	if (ft_strncmp(a->s + a->pos, op, len))
+		return (0);
+	if (a->s[a->pos + len] && ft_strchr(not_followed, a->s[a->pos + len]))
+		return (0);
+	a->pos += len;
+	return (1);
+}
+
+static long long	wrap(unsigned long long v)
+{
+	return ((long long)v);
+}
+
+// Decimal text of a 64-bit value, LLONG_MIN included (allocated)
+char	*arith_itoa(long long value)
+{
+	char	buf[24];
+	int		i;
+	int		neg;
+
+	i = 23;
+	buf[i] = '\0';
+	neg = (value < 0);
+	if (value == 0)
+		buf[--i] = '0';
+	while (value)
+	{
+		if (neg)
+			buf[--i] = '0' - (value % 10);
+		else
+			buf[--i] = '0' + (value % 10);
+		value /= 10;
+	}
+	if (neg)
+		buf[--i] = '-';
+	return (ft_strdup(buf + i));
+}
+
+static void	store_var(t_arith *a, const char *name, long long value)
+{
+	char	*text;
+
+	if (a->skip || a->error)
+		return ;
+	text = arith_itoa(value);
+	if (!text || !set_env_value(&a->env_list, (char *)name, text))
+		arith_error(a, "out of memory");
+	free(text);
+}
+
+static long long	parse_number(t_arith *a)
+{
+	unsigned long long	v;
+	int					base;
+	int					d;
+
+	base = 10;
+	if (a->s[a->pos] == '0' && (a->s[a->pos + 1] == 'x'
+			|| a->s[a->pos + 1] == 'X'))
+	{
+		base = 16;
+		a->pos += 2;
+	}
+	else if (a->s[a->pos] == '0')
+		base = 8;
+	v = 0;
+	while (ft_isalnum(a->s[a->pos]))
+	{
+		d = 99;
+		if (ft_isdigit(a->s[a->pos]))
+			d = a->s[a->pos] - '0';
+		else if (ft_isalpha(a->s[a->pos]))
+			d = ft_tolower(a->s[a->pos]) - 'a' + 10;
+		if (d >= base)
+			return (arith_error(a, "value too great for base"));
+		v = v * base + d;
+		a->pos++;
+	}
+	return (wrap(v));
+}
+
+static long long	eval_text(t_arith *a, const char *text);
+
+// Value of a variable: unset or empty is 0, anything else is evaluated
+static long long	var_value(t_arith *a, const char *name)
+{
+	char	*value;
+
+	value = get_env_value(a->env_list, (char *)name);
+	if (!value || !*value)
+		return (0);
+	if (a->depth >= 32)
+		return (arith_error(a, "expression recursion level exceeded"));
+	return (eval_text(a, value));
+}
+
+// Reads an identifier into name (truncated to fit); returns its length
+static int	read_name(t_arith *a, char *name, size_t size)
+{
+	int	len;
+
+	skip_spaces(a);
+	len = 0;
+	if (!ft_isalpha(a->s[a->pos]) && a->s[a->pos] != '_')
+		return (0);
+	while (ft_isalnum(a->s[a->pos + len]) || a->s[a->pos + len] == '_')
+	{
+		if ((size_t)len + 1 < size)
+			name[len] = a->s[a->pos + len];
+		len++;
+	}
+	if ((size_t)len < size)
+		name[len] = '\0';
+	else
+		name[size - 1] = '\0';
+	return (len);
+}
+
+static long long	arith_primary(t_arith *a)
+{
+	char		name[256];
+	long long	v;
+	int			len;
+
+	skip_spaces(a);
+	if (accept(a, "(", ""))
+	{
+		v = arith_comma(a);
+		if (!accept(a, ")", ""))
+			return (arith_error(a, "missing `)'"));
+		return (v);
+	}
+	if (ft_isdigit(a->s[a->pos]))
+		return (parse_number(a));
+	len = read_name(a, name, sizeof(name));
+	if (!len)
+		return (arith_error(a, "syntax error: operand expected"));
+	a->pos += len;
+	v = var_value(a, name);
+	if (accept(a, "++", ""))
+		store_var(a, name, wrap((unsigned long long)v + 1));
+	else if (accept(a, "--", ""))
+		store_var(a, name, wrap((unsigned long long)v - 1));
+	return (v);
+}
+
+static long long	arith_prefix(t_arith *a, int delta)
+{
+	char		name[256];
+	long long	v;
+	int			len;
+
+	len = read_name(a, name, sizeof(name));
+	if (!len)
+		return (arith_error(a, "syntax error: operand expected"));
+	a->pos += len;
+	v = wrap((unsigned long long)var_value(a, name) + delta);
+	store_var(a, name, v);
+	return (v);
+}
+
+static long long	arith_unary(t_arith *a)
+{
+	if (accept(a, "++", ""))
+		return (arith_prefix(a, 1));
+	if (accept(a, "--", ""))
+		return (arith_prefix(a, -1));
+	if (accept(a, "+", ""))
+		return (arith_unary(a));
+	if (accept(a, "-", ""))
+		return (wrap(0ULL - (unsigned long long)arith_unary(a)));
+	if (accept(a, "!", "="))
+		return (!arith_unary(a));
+	if (accept(a, "~", ""))
+		return (~arith_unary(a));
+	return (arith_primary(a));
+}
+
+// ** is right associative and binds tighter than * / %
+static long long	arith_power(t_arith *a)
+{
+	long long			base;
+	long long			exp;
+	unsigned long long	r;
+
+	base = arith_unary(a);
+	if (!accept(a, "**", "="))
+		return (base);
+	exp = arith_power(a);
+	if (exp < 0)
+		return (arith_error(a, "exponent less than 0"));
+	r = 1;
+	while (exp > 0)
+	{
+		if (exp & 1)
+			r *= (unsigned long long)base;
+		base = wrap((unsigned long long)base * base);
+		exp >>= 1;
+	}
+	return (wrap(r));
+}
+
+static long long	divide(t_arith *a, long long l, long long r, int mod)
+{
+	if (r == 0)
+		return (arith_error(a, "division by 0"));
+	if (l == LLONG_MIN && r == -1)
+	{
+		if (mod)
+			return (0);
+		return (LLONG_MIN);
+	}
+	if (mod)
+		return (l % r);
+	return (l / r);
+}
+
+static long long	arith_mul(t_arith *a)
+{
+	long long	v;
+
+	v = arith_power(a);
+	while (!a->error)
+	{
+		if (accept(a, "*", "*="))
+			v = wrap((unsigned long long)v * arith_power(a));
+		else if (accept(a, "/", "="))
+			v = divide(a, v, arith_power(a), 0);
+		else if (accept(a, "%", "="))
+			v = divide(a, v, arith_power(a), 1);
+		else
+			break ;
+	}
+	return (v);
+}
+
+static long long	arith_add(t_arith *a)
+{
+	long long	v;
+
+	v = arith_mul(a);
+	while (!a->error)
+	{
+		if (accept(a, "+", "+="))
+			v = wrap((unsigned long long)v + arith_mul(a));
+		else if (accept(a, "-", "-="))
+			v = wrap((unsigned long long)v - arith_mul(a));
+		else
+			break ;
+	}
+	return (v);
+}
+
+static long long	shift(long long v, long long by, int left)
+{
+	by &= 63;
+	if (left)
+		return (wrap((unsigned long long)v << by));
+	return (v >> by);
+}
+
+static long long	arith_shift(t_arith *a)
+{
+	long long	v;
+
+	v = arith_add(a);
+	while (!a->error)
+	{
+		if (accept(a, "<<", "="))
+			v = shift(v, arith_add(a), 1);
+		else if (accept(a, ">>", "="))
+			v = shift(v, arith_add(a), 0);
+		else
+			break ;
+	}
+	return (v);
+}
+
+static long long	arith_rel(t_arith *a)
+{
+	long long	v;
+
+	v = arith_shift(a);
+	while (!a->error)
+	{
+		if (accept(a, "<=", ""))
+			v = (v <= arith_shift(a));
+		else if (accept(a, ">=", ""))
+			v = (v >= arith_shift(a));
+		else if (accept(a, "<", "<"))
+			v = (v < arith_shift(a));
+		else if (accept(a, ">", ">"))
+			v = (v > arith_shift(a));
+		else
+			break ;
+	}
+	return (v);
+}
+
+static long long	arith_eq(t_arith *a)
+{
+	long long	v;
+
+	v = arith_rel(a);
+	while (!a->error)
+	{
+		if (accept(a, "==", ""))
+			v = (v == arith_rel(a));
+		else if (accept(a, "!=", ""))
+			v = (v != arith_rel(a));
+		else
+			break ;
+	}
+	return (v);
+}
+
+static long long	arith_bitand(t_arith *a)
+{
+	long long	v;
+
+	v = arith_eq(a);
+	while (!a->error && accept(a, "&", "&="))
+		v &= arith_eq(a);
+	return (v);
+}
+
+static long long	arith_bitxor(t_arith *a)
+{
+	long long	v;
+
+	v = arith_bitand(a);
+	while (!a->error && accept(a, "^", "="))
+		v ^= arith_bitand(a);
+	return (v);
+}
+
+static long long	arith_bitor(t_arith *a)
+{
+	long long	v;
+
+	v = arith_bitxor(a);
+	while (!a->error && accept(a, "|", "|="))
+		v |= arith_bitxor(a);
+	return (v);
+}
+
+// Evaluates the right operand of && || ?: with side effects turned off
+// when it does not count
+static long long	eval_skipped(t_arith *a, long long (*f)(t_arith *),
+		int skip)
+{
+	int			saved;
+	long long	v;
+
+	saved = a->skip;
+	a->skip = saved || skip;
+	v = f(a);
+	a->skip = saved;
+	return (v);
+}
+
+static long long	arith_logand(t_arith *a)
+{
+	long long	v;
+
+	v = arith_bitor(a);
+	while (!a->error && accept(a, "&&", ""))
+		v = (eval_skipped(a, arith_bitor, !v) && v);
+	return (v);
+}
+
+static long long	arith_logor(t_arith *a)
+{
+	long long	v;
+
+	v = arith_logand(a);
+	while (!a->error && accept(a, "||", ""))
+		v = (eval_skipped(a, arith_logand, v != 0) || v);
+	return (v);
+}
+
+static long long	arith_ternary(t_arith *a)
+{
+	long long	cond;
+	long long	yes;
+	long long	no;
+
+	cond = arith_logor(a);
+	if (a->error || !accept(a, "?", ""))
+		return (cond);
+	yes = eval_skipped(a, arith_assign, !cond);
+	if (!accept(a, ":", ""))
+		return (arith_error(a, "`:' expected for conditional expression"));
+	no = eval_skipped(a, arith_ternary, cond != 0);
+	if (cond)
+		return (yes);
+	return (no);
+}
+
+// Applies the operator of a compound assignment ("+=", "<<=", ...)
+static long long	apply_assign_op(t_arith *a, const char *op, long long l,
+		long long r)
+{
+	if (op[0] == '+')
+		return (wrap((unsigned long long)l + r));
+	if (op[0] == '-')
+		return (wrap((unsigned long long)l - r));
+	if (op[0] == '*')
+		return (wrap((unsigned long long)l * r));
+	if (op[0] == '/' || op[0] == '%')
+		return (divide(a, l, r, op[0] == '%'));
+	if (op[0] == '<' || op[0] == '>')
+		return (shift(l, r, op[0] == '<'));
+	if (op[0] == '&')
+		return (l & r);
+	if (op[0] == '^')
+		return (l ^ r);
+	if (op[0] == '|')
+		return (l | r);
+	return (r);
+}
+
+static long long	arith_assign(t_arith *a)
+{
+	static const char	*ops[] = {"<<=", ">>=", "+=", "-=", "*=", "/=", "%=",
+		"&=", "^=", "|=", "=", NULL};
+	char				name[256];
+	int					start;
+	int					len;
+	int					i;
+	long long			v;
+
+	start = a->pos;
+	len = read_name(a, name, sizeof(name));
+	if (len)
+	{
+		a->pos += len;
+		i = 0;
+		while (ops[i] && !accept(a, ops[i], "="))
+			i++;
+		if (ops[i])
+		{
+			v = arith_assign(a);
+			v = apply_assign_op(a, ops[i], var_value(a, name), v);
+			store_var(a, name, v);
+			return (v);
+		}
+	}
+	a->pos = start;
+	return (arith_ternary(a));
+}
+
+static long long	arith_comma(t_arith *a)
+{
+	long long	v;
+
+	v = arith_assign(a);
+	while (!a->error && accept(a, ",", ""))
+		v = arith_assign(a);
+	return (v);
+}
+
+static long long	eval_text(t_arith *a, const char *text)
+{
+	t_arith		sub;
+	long long	v;
+
+	sub = *a;
+	sub.s = text;
+	sub.pos = 0;
+	sub.depth = a->depth + 1;
+	v = arith_comma(&sub);
+	skip_spaces(&sub);
+	if (!sub.error && sub.s[sub.pos])
+		arith_error(&sub, "syntax error in expression");
+	a->error = sub.error;
+	a->env_list = sub.env_list;
+	return (v);
+}
+
+// Evaluates expr (already parameter-expanded); returns 0 on error
+int	eval_arith(const char *expr, t_env *env_list, long long *result)
+{
+	t_arith	a;
+
+	ft_memset(&a, 0, sizeof(t_arith));
+	a.expr = expr;
+	a.s = expr;
+	a.env_list = env_list;
+	skip_spaces(&a);
+	*result = 0;
+	if (!a.s[a.pos])
+		return (1);
+	*result = eval_text(&a, expr);
+	return (!a.error);
+}
@@ -0,0 +1,267 @@
+#include "minishell.h"
+
+// Brace expansion: "a{b,c}d" gives "abd acd" and "{1..10..2}", "{01..10}"
+// or "{a..z}" give sequences. It runs on the escaped form of a word built
+// by the parser, so quoted braces and commas are not special, and every
+// word it makes goes straight to the argument vector (through pathname
+// expansion when it has unquoted pattern characters); nothing is built
+// as tokens first. A sequence is generated one value at a time, and one
+// that cannot fit in the ARG_MAX budget is refused before it starts.
+// Words that come out empty, as in "a{,}", are dropped. Braces and
+// commas that come from expansions are escaped like quoted ones, so only
+// those written in the word are special.
+
+// "-012" -> value, with the number of characters and whether it is
+// zero-padded; 0 if s does not start with at most 18 digits
+static int	parse_bound(const char **s, long *value, int *width, int *pad)
+{
+	const char	*start;
+	char		*end;
+
+	start = *s;
+	if (!ft_isdigit(start[start[0] == '-']))
+		return (0);
+	*value = strtol(start, &end, 10);
+	if (end - start > 18 + (start[0] == '-'))
+		return (0);
+	if (end - start > *width)
+		*width = end - start;
+	if (start[start[0] == '-'] == '0' && end - start > 1 + (start[0] == '-'))
+		*pad = 1;
+	*s = end;
+	return (1);
+}
+
+// Whether s, the inside of a pair of braces, is a sequence
+static int	parse_sequence(const char *s, t_seq *seq)
+{
+	int	unused;
+
+	ft_memset(seq, 0, sizeof(t_seq));
+	seq->step = 1;
+	if (ft_isalpha(s[0]) && s[1] == '.' && s[2] == '.' && ft_isalpha(s[3]))
+	{
+		seq->chars = 1;
+		seq->from = s[0];
+		seq->to = s[3];
+		s += 4;
+	}
+	else
+	{
+		if (!parse_bound(&s, &seq->from, &seq->width, &seq->pad)
+			|| s[0] != '.' || s[1] != '.')
+			return (0);
+		s += 2;
+		if (!parse_bound(&s, &seq->to, &seq->width, &seq->pad))
+			return (0);
+	}
+	if (s[0] == '.' && s[1] == '.')
+	{
+		s += 2;
+		unused = 0;
+		if (!parse_bound(&s, &seq->step, &unused, &unused))
+			return (0);
+		seq->step = labs(seq->step);
+		if (seq->step == 0)
+			seq->step = 1;
+	}
+	return (*s == '}');
+}
+
+// Finds the first brace group of s; returns BRACE_LIST, BRACE_SEQ or
+// BRACE_NONE, with the offsets of its '{' and '}'
+int	brace_find(const char *s, size_t *open, size_t *close)
+{
+	size_t	i;
+	int		depth;
+	int		comma;
+	t_seq	seq;
+
+	while (s[*open])
+	{
+		if (s[*open] == '\\' && s[*open + 1])
+			(*open)++;
+		else if (s[*open] == '{')
+		{
+			depth = 0;
+			comma = 0;
+			i = *open;
+			while (s[++i] && (s[i] != '}' || depth))
+			{
+				if (s[i] == '\\' && s[i + 1])
+					i++;
+				else if (s[i] == '{' || s[i] == '}')
+					depth += (s[i] == '{') - (s[i] == '}');
+				else
+					comma |= (s[i] == ',' && !depth);
+			}
+			*close = i;
+			if (s[i] && comma)
+				return (BRACE_LIST);
+			if (s[i] && parse_sequence(s + *open + 1, &seq))
+				return (BRACE_SEQ);
+		}
+		(*open)++;
+	}
+	return (BRACE_NONE);
+}
+
+// Writes n bytes of s at b->buf + at, keeping the buffer terminated
+static int	buf_put(t_brace *b, size_t at, const char *s, size_t n)
+{
+	char	*grown;
+	size_t	cap;
+
+	if (at + n + 1 > b->cap)
+	{
+		cap = b->cap * 2;
+		if (cap < at + n + 1)
+			cap = at + n + 64;
+		grown = realloc(b->buf, cap);
+		if (!grown)
+			return (0);
+		b->buf = grown;
+		b->cap = cap;
+	}
+	ft_memcpy(b->buf + at, s, n);
+	b->buf[at + n] = '\0';
+	return (1);
+}
+
+static int	brace_gen(t_brace *b, size_t plen, const char *rest);
+
+static char	*join_alt(const char *alt, size_t n, const char *suffix)
+{
+	char	*word;
+	size_t	len;
+
+	len = ft_strlen(suffix);
+	word = malloc(n + len + 1);
+	if (!word)
+		return (NULL);
+	ft_memcpy(word, alt, n);
+	ft_memcpy(word + n, suffix, len + 1);
+	return (word);
+}
+
+// "{a,b{c,d}}": every top-level alternative followed by the suffix
+static int	brace_list(t_brace *b, size_t plen, const char *group,
+		const char *suffix)
+{
+	char	*word;
+	size_t	start;
+	size_t	i;
+	int		depth;
+	int		ok;
+
+	ok = 1;
+	depth = 0;
+	start = 1;
+	i = 0;
+	while (ok > 0 && group[++i])
+	{
+		if (group[i] == '\\' && group[i + 1])
+			i++;
+		else if (group[i] == '{')
+			depth++;
+		else if (group[i] == '}' && depth)
+			depth--;
+		else if ((group[i] == ',' || group[i] == '}') && !depth)
+		{
+			word = join_alt(group + start, i - start, suffix);
+			ok = (word != NULL);
+			if (ok)
+				ok = brace_gen(b, plen, word);
+			free(word);
+			start = i + 1;
+			if (group[i] == '}')
+				break ;
+		}
+	}
+	return (ok);
+}
+
+// "{1..10..3}", "{05..1}", "{a..e}": one value at a time
+static int	brace_sequence(t_brace *b, size_t plen, const char *group,
+		const char *suffix)
+{
+	t_seq			seq;
+	unsigned long	count;
+	char			num[48];
+	int				n;
+	int				ok;
+
+	parse_sequence(group + 1, &seq);
+	count = (unsigned long)labs(seq.to - seq.from) / seq.step + 1;
+	if (b->limit && count > (b->limit - b->args->bytes) / (sizeof(char *) + 2))
+		return (-1);
+	ok = 1;
+	while (ok > 0 && count--)
+	{
+		if (seq.chars && ft_strchr("\\*?[]{},", seq.from))
+			n = snprintf(num, sizeof(num), "\\%c", (char)seq.from);
+		else if (seq.chars)
+			n = snprintf(num, sizeof(num), "%c", (char)seq.from);
+		else if (seq.pad)
+			n = snprintf(num, sizeof(num), "%0*ld", seq.width, seq.from);
+		else
+			n = snprintf(num, sizeof(num), "%ld", seq.from);
+		ok = buf_put(b, plen, num, n);
+		if (ok)
+			ok = brace_gen(b, plen + n, suffix);
+		if (seq.to >= seq.from)
+			seq.from += seq.step;
+		else
+			seq.from -= seq.step;
+	}
+	return (ok);
+}
+
+// Expands rest after the plen bytes already in b->buf. 1 on success, 0
+// when out of memory, -1 when the arguments outgrow b->limit.
+static int	brace_gen(t_brace *b, size_t plen, const char *rest)
+{
+	size_t	open;
+	size_t	close;
+	char	**names;
+	int		kind;
+	int		ok;
+
+	open = 0;
+	kind = brace_find(rest, &open, &close);
+	if (kind == BRACE_NONE)
+	{
+		if (!buf_put(b, plen, rest, ft_strlen(rest)))
+			return (0);
+		if (!*b->buf)
+			return (1);
+		names = NULL;
+		if (pattern_is_magic(b->buf))
+			names = glob_word(b->buf, b->env);
+		if (names)
+			ok = argv_push_all(b->args, names);
+		else
+			ok = argv_push(b->args, glob_unescape(b->buf));
+		if (ok && b->limit && b->args->bytes > b->limit)
+			return (-1);
+		return (ok);
+	}
+	if (!buf_put(b, plen, rest, open))
+		return (0);
+	if (kind == BRACE_SEQ)
+		return (brace_sequence(b, plen + open, rest + open,
+				rest + close + 1));
+	return (brace_list(b, plen + open, rest + open, rest + close + 1));
+}
+
+// Expands the braces of word (in escaped form) into args
+int	brace_expand(t_brace *b, const char *word)
+{
+	int	ok;
+
+	b->buf = NULL;
+	b->cap = 0;
+	ok = brace_gen(b, 0, word);
+	free(b->buf);
+	return (ok);
+}
@@ -0,0 +1,190 @@
+#define _GNU_SOURCE
+#include "minishell.h"
+#include <sys/mman.h>
+
+// $( list ): the list is parsed once through the parse cache and run in a
+// child whose stdout is a pipe; the parent reads it into a buffer that
+// doubles as it fills. A single builtin that cannot change shell state
+// (echo, pwd, env, test) runs in this process instead, with stdout pointed
+// at a memfd for the duration. Trailing newlines are removed either way.
+// The exit status of the last substitution is kept for a command made of
+// assignments only, whose status it becomes.
+
+#define SUBST_CHUNK 4096
+
+static int	g_subst_status = -1;
+
+// Forgets the status of earlier substitutions; done before each command
+void	subst_status_reset(void)
+{
+	g_subst_status = -1;
+}
+
+// Exit status of the last substitution since subst_status_reset(), or -1
+int	subst_status(void)
+{
+	return (g_subst_status);
+}
+
+// Builtins that only write output, so running them here is unobservable
+static int	is_pure_builtin(const char *name)
+{
+	return (!ft_strcmp(name, "echo") || !ft_strcmp(name, "pwd")
+		|| !ft_strcmp(name, "env") || !ft_strcmp(name, "test")
+		|| !ft_strcmp(name, "[") || !ft_strcmp(name, "[["));
+}
+
+// One plain pipeline of a single pure builtin, with no $(( )) or ${ }
+// that could assign a variable or exit the shell (${x=v}, ${x:?msg})
+static int	runs_in_process(t_node *list)
+{
+	t_elem	*tok;
+
+	if (list->kind != NODE_PIPELINE || list->next
+		|| list->op == OP_BACKGROUND)
+		return (0);
+	tok = list->tokens;
+	while (tok && tok->type == WHITE_SPACE)
+		tok = tok->next;
+	if (!tok || tok->type != WORD || tok->state != GENERAL
+		|| !is_pure_builtin(tok->content) || find_function(tok->content))
+		return (0);
+	while (tok)
+	{
+		if (tok->type == PIPE_LINE || ft_strnstr(tok->content, "$((",
+				ft_strlen(tok->content)) || ft_strnstr(tok->content, "${",
+				ft_strlen(tok->content)))
+			return (0);
+		tok = tok->next;
+	}
+	return (1);
+}
+
+// Reads fd to EOF into a growing buffer; *len gets the byte count
+static char	*read_all(int fd, size_t *len)
+{
+	char	*buf;
+	char	*bigger;
+	size_t	cap;
+	ssize_t	n;
+
+	cap = SUBST_CHUNK;
+	buf = malloc(cap + 1);
+	*len = 0;
+	while (buf)
+	{
+		if (*len == cap)
+		{
+			cap *= 2;
+			bigger = malloc(cap + 1);
+			if (bigger)
+				ft_memcpy(bigger, buf, *len);
+			free(buf);
+			buf = bigger;
+			continue ;
+		}
+		n = read(fd, buf + *len, cap - *len);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n <= 0)
+			break ;
+		*len += n;
+	}
+	return (buf);
+}
+
+static char	*capture_in_process(t_node *list, int exit_code,
+		t_env **env_list, size_t *len)
+{
+	int		fd;
+	int		saved;
+	char	*out;
+
+	fd = memfd_create("minishell-subst", MFD_CLOEXEC);
+	if (fd < 0)
+		return (NULL);
+	fflush(stdout);
+	saved = dup(STDOUT_FILENO);
+	dup2(fd, STDOUT_FILENO);
+	run_pipeline_node(list->tokens, 0, &exit_code, env_list);
+	g_subst_status = exit_code;
+	fflush(stdout);
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+	lseek(fd, 0, SEEK_SET);
+	out = read_all(fd, len);
+	close(fd);
+	return (out);
+}
+
+static char	*capture_child(t_node *list, int exit_code, t_env **env_list,
+		size_t *len)
+{
+	int		fds[2];
+	int		status;
+	pid_t	pid;
+	char	*out;
+
+	if (pipe(fds) < 0)
+		return (NULL);
+	fflush(stdout);
+	pid = shell_fork();
+	if (pid == 0)
+	{
+		default_signals();
+		close(fds[0]);
+		dup2(fds[1], STDOUT_FILENO);
+		close(fds[1]);
+		set_tail_exec(1);
+		execute_list(list, &exit_code, env_list);
+		fflush(stdout);
+		exit(exit_code);
+	}
+	close(fds[1]);
+	out = NULL;
+	if (pid > 0)
+	{
+		set_child_running();
+		out = read_all(fds[0], len);
+		status = 0;
+		wait_child(pid, &status);
+		set_child_finished();
+		g_subst_status = WEXITSTATUS(status);
+		if (WIFSIGNALED(status))
+			g_subst_status = 128 + WTERMSIG(status);
+	}
+	else
+		perror("fork");
+	close(fds[0]);
+	return (out);
+}
+
+// Output of the command list text, without its trailing newlines
+char	*command_substitution(char *text, int exit_code, t_env *env_list)
+{
+	t_node	*list;
+	int		error;
+	int		cached;
+	char	*out;
+	size_t	len;
+
+	list = parse_cache_lookup(text, &cached, &error);
+	if (!list && error)
+		return (NULL);
+	if (!list)
+		return (ft_strdup(""));
+	if (runs_in_process(list))
+		out = capture_in_process(list, exit_code, &env_list, &len);
+	else
+		out = capture_child(list, exit_code, &env_list, &len);
+	if (cached)
+		parse_cache_release(list);
+	else
+		free_node_list(list);
+	if (!out)
+		return (NULL);
+	while (len > 0 && out[len - 1] == '\n')
+		len--;
+	out[len] = '\0';
+	return (out);
+}
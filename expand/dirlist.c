@@ -0,0 +1,206 @@
+#include "minishell.h"
+#include <sys/syscall.h>
+
+// Directory listings for pathname expansion. A directory is read with
+// getdents64(2) straight into one buffer, with no per-entry readdir() or
+// stat(); the entries point at the names inside the kernel records. The
+// listings read while one command's words are expanded are kept in a
+// hash table on their path until glob_cache_clear().
+
+static t_dirlist	**g_dirtab = NULL;
+static size_t		g_dirtab_size = 0;
+static size_t		g_dir_count = 0;
+
+// All getdents64 records of fd, back to back in dir->pool
+static long	read_records(t_dirlist *dir, int fd)
+{
+	size_t	cap;
+	size_t	len;
+	long	got;
+	char	*grown;
+
+	cap = GLOB_DENTS_BUF;
+	len = 0;
+	dir->pool = malloc(cap);
+	while (dir->pool)
+	{
+		if (cap - len < GLOB_DENTS_BUF)
+		{
+			grown = realloc(dir->pool, cap * 2);
+			if (!grown)
+				return (-1);
+			dir->pool = grown;
+			cap *= 2;
+		}
+		got = syscall(SYS_getdents64, fd, dir->pool + len, cap - len);
+		if (got < 0)
+			return (-1);
+		if (got == 0)
+			break ;
+		len += got;
+	}
+	grown = realloc(dir->pool, len + 1);
+	if (grown)
+		dir->pool = grown;
+	return (len);
+}
+
+// Points the entries at the names inside the records
+static void	index_records(t_dirlist *dir, long len)
+{
+	t_kdirent	*rec;
+	long		off;
+	int			n;
+
+	n = 0;
+	off = 0;
+	while (off < len)
+	{
+		n++;
+		off += ((t_kdirent *)(dir->pool + off))->d_reclen;
+	}
+	dir->ents = malloc(sizeof(t_dentry) * (n + 1));
+	off = 0;
+	while (dir->ents && off < len)
+	{
+		rec = (t_kdirent *)(dir->pool + off);
+		off += rec->d_reclen;
+		if (rec->d_name[0] == '.' && (!rec->d_name[1]
+				|| (rec->d_name[1] == '.' && !rec->d_name[2])))
+			continue ;
+		dir->ents[dir->count].name = rec->d_name;
+		dir->ents[dir->count].type = rec->d_type;
+		dir->ents[dir->count++].len = ft_strlen(rec->d_name);
+	}
+}
+
+// Listing of the directory open on fd, named path; empty if fd is -1 or
+// cannot be read. Safe to call from several threads.
+t_dirlist	*read_dirlist(int fd, const char *path)
+{
+	t_dirlist	*dir;
+	long		len;
+
+	dir = ft_calloc(1, sizeof(t_dirlist));
+	if (!dir)
+		return (NULL);
+	dir->path = ft_strdup(path);
+	if (!dir->path)
+	{
+		free(dir);
+		return (NULL);
+	}
+	if (fd < 0)
+		return (dir);
+	len = read_records(dir, fd);
+	if (len > 0)
+		index_records(dir, len);
+	return (dir);
+}
+
+void	free_dirlist(t_dirlist *dir)
+{
+	if (!dir)
+		return ;
+	free(dir->path);
+	free(dir->ents);
+	free(dir->pool);
+	free(dir);
+}
+
+static unsigned long	hash_path(const char *s)
+{
+	unsigned long	h;
+
+	h = 5381;
+	while (*s)
+		h = h * 33 + (unsigned char)*s++;
+	return (h);
+}
+
+t_dirlist	*glob_cache_find(const char *path)
+{
+	t_dirlist	*dir;
+
+	if (!g_dirtab)
+		return (NULL);
+	dir = g_dirtab[hash_path(path) & (g_dirtab_size - 1)];
+	while (dir && ft_strcmp(dir->path, path))
+		dir = dir->next;
+	return (dir);
+}
+
+static int	grow_dirtab(void)
+{
+	t_dirlist	**table;
+	t_dirlist	*dir;
+	size_t		size;
+	size_t		i;
+
+	size = g_dirtab_size * 2;
+	if (size < 64)
+		size = 64;
+	table = ft_calloc(size, sizeof(t_dirlist *));
+	if (!table)
+		return (0);
+	i = 0;
+	while (i < g_dirtab_size)
+	{
+		while (g_dirtab[i])
+		{
+			dir = g_dirtab[i];
+			g_dirtab[i] = dir->next;
+			dir->next = table[hash_path(dir->path) & (size - 1)];
+			table[hash_path(dir->path) & (size - 1)] = dir;
+		}
+		i++;
+	}
+	free(g_dirtab);
+	g_dirtab = table;
+	g_dirtab_size = size;
+	return (1);
+}
+
+// Keeps dir in the cache and returns the cached listing of its path (an
+// older one wins; dir is then freed)
+t_dirlist	*glob_cache_add(t_dirlist *dir)
+{
+	t_dirlist	*old;
+	t_dirlist	**slot;
+
+	if (!dir)
+		return (NULL);
+	old = glob_cache_find(dir->path);
+	if (old || (g_dir_count >= g_dirtab_size && !grow_dirtab()))
+	{
+		free_dirlist(dir);
+		return (old);
+	}
+	slot = &g_dirtab[hash_path(dir->path) & (g_dirtab_size - 1)];
+	dir->next = *slot;
+	*slot = dir;
+	g_dir_count++;
+	return (dir);
+}
+
+void	glob_cache_clear(void)
+{
+	t_dirlist	*next;
+	size_t		i;
+
+	i = 0;
+	while (i < g_dirtab_size)
+	{
+		while (g_dirtab[i])
+		{
+			next = g_dirtab[i]->next;
+			free_dirlist(g_dirtab[i]);
+			g_dirtab[i] = next;
+		}
+		i++;
+	}
+	free(g_dirtab);
+	g_dirtab = NULL;
+	g_dirtab_size = 0;
+	g_dir_count = 0;
+}
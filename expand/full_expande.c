@@ -5,6 +5,19 @@ int is_valid_var_char(char c)
     return (ft_isalnum(c) || c == '_');
 }
 
+// A shell variable name: a letter or '_' followed by letters, digits or '_'
+int is_valid_identifier(const char *name)
+{
+    int i;
+
+    if (!name || !(ft_isalpha(name[0]) || name[0] == '_'))
+        return (0);
+    i = 1;
+    while (name[i] && is_valid_var_char(name[i]))
+        i++;
+    return (name[i] == '\0');
+}
+
 char *realloc_result(char *result, int *max_size, int needed)
 {
     char *new_result;
@@ -49,10 +62,12 @@ char *extract_var_name(char *str, int start, int *end)
         return (NULL);
     
     i = start;
-    if (str[i] == '?')
+    // $?, the positional parameters $0..$9 and $#, $@, $* are one character
+    if (str[i] == '?' || ft_isdigit(str[i]) || str[i] == '#'
+        || str[i] == '@' || str[i] == '*')
     {
         *end = i + 1;
-        return (ft_strdup("?"));
+        return (ft_strndup(str + i, 1));
     }
     
     while (str[i] && is_valid_var_char(str[i]))
@@ -81,6 +96,12 @@ int handle_special_var(char *name, int exit_code, char **value, t_env *env_list)
         *value = expand_exit_status(exit_code);
         return (1); // indicates we allocated memory for value
     }
+    if (ft_isdigit(name[0]) || name[0] == '#' || name[0] == '@'
+        || name[0] == '*')
+    {
+        *value = positional_value(name, env_list);
+        return (1);
+    }
     
     *value = get_env_value(env_list, name);
     return (0); // indicates value points to existing memory
@@ -113,6 +134,110 @@ int process_regular_char(char *content, int *i, t_expand_data *data)
     return (1);
 }
 
+// $(( expr )): the expression is parameter-expanded first, then evaluated.
+// *i is on the first '('. Returns 0 (failing the expansion) on errors.
+int process_arith_expansion(char *content, int *i, t_expand_data *data)
+{
+    int end;
+    char *expr;
+    char *expanded;
+    long long value;
+    char *text;
+    int ok;
+
+    end = skip_dollar_paren(content, *i - 1);
+    if (end - *i < 4 || content[end - 1] != ')' || content[end - 2] != ')')
+    {
+        ft_putstr_fd("minishell: bad substitution: missing `))'\n", 2);
+        return (0);
+    }
+    expr = ft_strndup(content + *i + 2, end - *i - 4);
+    if (!expr)
+        return (0);
+    expanded = expand_token_content(expr, data->exit_code, 1, data->env_list);
+    free(expr);
+    if (!expanded)
+        return (0);
+    ok = eval_arith(expanded, data->env_list, &value);
+    free(expanded);
+    if (!ok)
+        return (0);
+    text = arith_itoa(value);
+    ok = (text && copy_var_value(data->res, data->len, data->max, text));
+    free(text);
+    *i = end;
+    return (ok);
+}
+
+// $( list ): replaced by the output of the list
+int process_command_subst(char *content, int *i, t_expand_data *data)
+{
+    int end;
+    char *text;
+    char *output;
+    int ok;
+
+    end = skip_dollar_paren(content, *i - 1);
+    if (content[end - 1] != ')')
+    {
+        ft_putstr_fd("minishell: bad substitution: missing `)'\n", 2);
+        return (0);
+    }
+    text = ft_strndup(content + *i + 1, end - *i - 2);
+    if (!text)
+        return (0);
+    output = command_substitution(text, data->exit_code, data->env_list);
+    free(text);
+    if (!output)
+        return (0);
+    ok = copy_var_value(data->res, data->len, data->max, output);
+    free(output);
+    *i = end;
+    return (ok);
+}
+
+// Remembers that the byte at offset at of the result ends a field; with
+// at -1 only makes sure the list exists
+static int add_break(t_spans *fields, int at)
+{
+    int *grown;
+
+    if (!fields->at || fields->count + 2 > fields->cap)
+    {
+        grown = realloc(fields->at, sizeof(int) * (fields->cap * 2 + 8));
+        if (!grown)
+            return (0);
+        fields->at = grown;
+        fields->cap = fields->cap * 2 + 8;
+    }
+    if (at >= 0)
+        fields->at[fields->count++] = at;
+    fields->at[fields->count] = -1;
+    return (1);
+}
+
+// "$@": the parameters joined with spaces, each of which ends a field
+static int expand_quoted_at(t_expand_data *data)
+{
+    t_frame *frame;
+    int i;
+
+    frame = current_frame();
+    if (!add_break(data->fields, -1))
+        return (0);
+    i = 1;
+    while (i < frame->count)
+    {
+        if (i > 1 && (!add_break(data->fields, *(data->len))
+                || !copy_var_value(data->res, data->len, data->max, " ")))
+            return (0);
+        if (!copy_var_value(data->res, data->len, data->max, frame->args[i]))
+            return (0);
+        i++;
+    }
+    return (1);
+}
+
 // Updated to use env_list from data structure
 int process_dollar_expansion(char *content, int *i, t_expand_data *data)
 {
@@ -123,6 +248,17 @@ int process_dollar_expansion(char *content, int *i, t_expand_data *data)
 
     if (!content || !i || !data)
         return (0);
+    if (content[*i] == '(' && content[*i + 1] == '(')
+        return (process_arith_expansion(content, i, data));
+    if (content[*i] == '(')
+        return (process_command_subst(content, i, data));
+    if (content[*i] == '{')
+        return (process_param_expansion(content, i, data));
+    if (content[*i] == '@' && data->fields)
+    {
+        (*i)++;
+        return (expand_quoted_at(data));
+    }
 
     name = extract_var_name(content, *i, &var_end);
     if (name)
@@ -145,9 +281,30 @@ int process_dollar_expansion(char *content, int *i, t_expand_data *data)
     return (1);
 }
 
+// Remembers that bytes [start, end) of the result came from an expansion
+static int add_span(t_spans *spans, int start, int end)
+{
+    int *grown;
+
+    if (spans->count + 3 > spans->cap)
+    {
+        grown = realloc(spans->at, sizeof(int) * (spans->cap * 2 + 8));
+        if (!grown)
+            return (0);
+        spans->at = grown;
+        spans->cap = spans->cap * 2 + 8;
+    }
+    spans->at[spans->count++] = start;
+    spans->at[spans->count++] = end;
+    spans->at[spans->count] = -1;
+    return (1);
+}
+
 int process_expansion_loop(char *content, t_expand_data *data)
 {
     int i;
+    int at;
+    int from;
 
     if (!content || !data)
         return (0);
@@ -157,9 +314,14 @@ int process_expansion_loop(char *content, t_expand_data *data)
     {
         if (content[i] == '$')
         {
-            i++;
+            at = ++i;
+            from = *(data->len);
             if (!process_dollar_expansion(content, &i, data))
                 return (0);
+            // a '$' that starts no expansion is copied and i stays put
+            if (data->spans && i != at
+                && !add_span(data->spans, from, *(data->len)))
+                return (0);
         }
         else if (!process_regular_char(content, &i, data))
             return (0);
@@ -167,12 +329,32 @@ int process_expansion_loop(char *content, t_expand_data *data)
     return (1);
 }
 
-// Updated to take env_list parameter
-char *expand_token_content(char *content, int exit_code, int should_expand, t_env *env_list)
+static char *expand_with(char *content, t_expand_data *data)
 {
     char *res;
     int len;
     int max;
+
+    len = 0;
+    max = 1024;
+    res = malloc(max);
+    if (!res)
+        return (NULL);
+    data->res = &res;
+    data->len = &len;
+    data->max = &max;
+    if (!process_expansion_loop(content, data))
+    {
+        free(res);
+        return (NULL);
+    }
+    res[len] = '\0';
+    return (res);
+}
+
+// Updated to take env_list parameter
+char *expand_token_content(char *content, int exit_code, int should_expand, t_env *env_list)
+{
     t_expand_data data;
 
     if (!content)
@@ -181,41 +363,114 @@ char *expand_token_content(char *content, int exit_code, int should_expand, t_en
     if (!should_expand)
         return (ft_strdup(content));
     
-    len = 0;
-    max = 1024;
-    res = malloc(max);
-    if (!res)
-        return (NULL);
-    
-    data.res = &res;
-    data.len = &len;
-    data.max = &max;
     data.exit_code = exit_code;
     data.env_list = env_list;
-    
-    if (!process_expansion_loop(content, &data))
+    data.spans = NULL;
+    data.fields = NULL;
+    return (expand_with(content, &data));
+}
+
+// An unquoted token: also records in curr->split which bytes came from
+// expansions, since only those are split into fields
+static char *expand_unquoted(t_elem *curr, int exit_code, t_env *env_list)
+{
+    t_expand_data data;
+    t_spans spans;
+    char *res;
+
+    ft_memset(&spans, 0, sizeof(t_spans));
+    data.exit_code = exit_code;
+    data.env_list = env_list;
+    data.spans = &spans;
+    data.fields = NULL;
+    res = expand_with(curr->content, &data);
+    free(curr->split);
+    curr->split = spans.at;
+    if (!res)
     {
-        free(res);
+        free(spans.at);
+        curr->split = NULL;
+    }
+    return (res);
+}
+
+// <(list) or >(list): its /dev/fd/N path and the rest of the word, or NULL
+static char *expand_proc_subst(char *content, int exit_code, t_env *env_list)
+{
+    int end;
+    char *text;
+    char *path;
+    char *rest;
+    char *joined;
+
+    end = skip_dollar_paren(content, 0);
+    if (content[end - 1] != ')')
+    {
+        ft_putstr_fd("minishell: bad substitution: missing `)'\n", 2);
         return (NULL);
     }
-    
-    res[len] = '\0';
+    text = ft_strndup(content + 2, end - 3);
+    if (!text)
+        return (NULL);
+    path = process_substitution(content[0], text, exit_code, env_list);
+    free(text);
+    if (!path)
+        return (NULL);
+    rest = expand_token_content(content + end, exit_code, 1, env_list);
+    joined = NULL;
+    if (rest)
+        joined = ft_strjoin(path, rest);
+    free(path);
+    free(rest);
+    return (joined);
+}
+
+// A double-quoted token: records in curr->fields where "$@" put one
+// parameter after another. A token that is left empty while "$@" had no
+// parameters gives no field at all, so it becomes an empty unquoted one.
+static char *expand_quoted(t_elem *curr, int exit_code, t_env *env_list)
+{
+    t_expand_data data;
+    t_spans fields;
+    char *res;
+
+    ft_memset(&fields, 0, sizeof(t_spans));
+    data.exit_code = exit_code;
+    data.env_list = env_list;
+    data.spans = NULL;
+    data.fields = &fields;
+    res = expand_with(curr->content, &data);
+    if (res && !*res && fields.at && current_frame()->count <= 1)
+        curr->state = GENERAL;
+    free(curr->fields);
+    curr->fields = NULL;
+    if (res && fields.count)
+        curr->fields = fields.at;
+    else
+        free(fields.at);
     return (res);
 }
 
-// Updated to take env_list parameter
-void handle_word_token(t_elem *curr, int exit_code, t_env *env_list)
+int handle_word_token(t_elem *curr, int exit_code, t_env *env_list)
 {
     int should_expand;
     char *exp;
 
     if (!curr || !curr->content)
-        return;
+        return (1);
     
     // NEVER expand inside a single-quoted token
     should_expand = (curr->state != IN_QUOTE);
     
-    exp = expand_token_content(curr->content, exit_code, should_expand, env_list);
+    if (curr->state == GENERAL && (curr->content[0] == '<'
+            || curr->content[0] == '>') && curr->content[1] == '(')
+        exp = expand_proc_subst(curr->content, exit_code, env_list);
+    else if (curr->state == GENERAL)
+        exp = expand_unquoted(curr, exit_code, env_list);
+    else if (curr->state == IN_DQUOTE)
+        exp = expand_quoted(curr, exit_code, env_list);
+    else
+        exp = expand_token_content(curr->content, exit_code, should_expand, env_list);
     if (exp)
     {
         free(curr->content);
@@ -223,6 +478,7 @@ void handle_word_token(t_elem *curr, int exit_code, t_env *env_list)
         curr->type = WORD;
         // keep curr->state unchanged – it may still be IN_DQUOTE or GENERAL
     }
+    return (exp != NULL);
 }
 
 char *remove_quotes(char *content, enum e_type quote_type)
@@ -251,18 +507,18 @@ char *remove_quotes(char *content, enum e_type quote_type)
 }
 
 // Updated to take env_list parameter
-void handle_quoted_token(t_elem *curr, int exit_code, t_env *env_list)
+int handle_quoted_token(t_elem *curr, int exit_code, t_env *env_list)
 {
     char *unquoted;
     char *expanded;
     int should_expand;
 
     if (!curr || !curr->content)
-        return;
+        return (1);
     
     unquoted = remove_quotes(curr->content, curr->type);
     if (!unquoted)
-        return;
+        return (0);
     
     // Only expand inside double quotes, not single quotes
     should_expand = (curr->type == DQUOTE);
@@ -276,24 +532,27 @@ void handle_quoted_token(t_elem *curr, int exit_code, t_env *env_list)
         curr->content = expanded;
         curr->type = WORD;
     }
+    return (expanded != NULL);
 }
 
-// Updated to take env_list parameter
-void expand_tokens(t_elem *token, int exit_code, t_env *env_list)
+// Updated to take env_list parameter. Returns 0 if an expansion failed
+// (bad arithmetic, ...); the command must then not run. Tilde prefixes
+// are resolved first, into quoted tokens that the loop leaves alone.
+int expand_tokens(t_elem *token, int exit_code, t_env *env_list)
 {
     t_elem *curr;
+    int ok;
 
-    if (!token)
-        return;
-    
+    ok = expand_tildes(token, env_list);
     curr = token;
-    while (curr)
+    while (curr && ok)
     {
         if (curr->type == QUOTE || curr->type == DQUOTE)
-            handle_quoted_token(curr, exit_code, env_list);
-        else if ((curr->type == WORD || curr->type == ENV) 
-                 && curr->state != IN_QUOTE)
-            handle_word_token(curr, exit_code, env_list);
+            ok = handle_quoted_token(curr, exit_code, env_list);
+        else if ((curr->type == WORD || curr->type == ENV
+                  || curr->type == EXIT_STATUS) && curr->state != IN_QUOTE)
+            ok = handle_word_token(curr, exit_code, env_list);
         curr = curr->next;
     }
-}
\ No newline at end of file
+    return (ok);
+}
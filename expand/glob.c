@@ -0,0 +1,306 @@
+#include "minishell.h"
+
+// Pathname expansion. A word is split at '/' and walked one component at
+// a time; components without *, ? or [ are appended as they are, the
+// others are compiled once and matched against the directory listing.
+// Listings (see dirlist.c) are kept until glob_cache_clear() so that
+// "ls *.c *.h" or "src/*/*.o" read each directory a single time. Names
+// starting with '.' need a pattern that starts with a '.', and "." and
+// ".." are never produced. A "**" component matches any number of
+// directories (see globstar.c).
+
+// Appends s (taken over, freed on failure) and keeps the vector
+// NULL-terminated; av->bytes counts what execve() will need for it
+int	argv_push(t_argv *av, char *s)
+{
+	char	**grown;
+	int		cap;
+
+	if (!s)
+		return (0);
+	if (av->count + 1 >= av->cap)
+	{
+		cap = av->cap * 2;
+		if (cap < 8)
+			cap = 8;
+		grown = realloc(av->v, sizeof(char *) * cap);
+		if (!grown)
+		{
+			free(s);
+			return (0);
+		}
+		av->v = grown;
+		av->cap = cap;
+	}
+	av->v[av->count++] = s;
+	av->v[av->count] = NULL;
+	av->bytes += ft_strlen(s) + 1 + sizeof(char *);
+	return (1);
+}
+
+// Appends every string of names and frees the array; 0 if names is NULL
+int	argv_push_all(t_argv *av, char **names)
+{
+	int	i;
+	int	ok;
+
+	if (!names)
+		return (0);
+	ok = 1;
+	i = 0;
+	while (names[i] && ok)
+		ok = argv_push(av, names[i++]);
+	while (names[i])
+		free(names[i++]);
+	free(names);
+	return (ok);
+}
+
+// Copy of s with the pattern and brace characters quoted, for the quoted
+// parts of a word
+char	*glob_escape(const char *s)
+{
+	char	*out;
+	int		i;
+	int		j;
+
+	out = malloc(ft_strlen(s) * 2 + 1);
+	if (!out)
+		return (NULL);
+	i = 0;
+	j = 0;
+	while (s[i])
+	{
+		if (ft_strchr("\\*?[]{},", s[i]))
+			out[j++] = '\\';
+		out[j++] = s[i++];
+	}
+	out[j] = '\0';
+	return (out);
+}
+
+// The word an escaped pattern stands for, when it matched nothing
+char	*glob_unescape(const char *s)
+{
+	char	*out;
+	int		i;
+	int		j;
+
+	out = malloc(ft_strlen(s) + 1);
+	if (!out)
+		return (NULL);
+	i = 0;
+	j = 0;
+	while (s[i])
+	{
+		if (s[i] == '\\' && s[i + 1])
+			i++;
+		out[j++] = s[i++];
+	}
+	out[j] = '\0';
+	return (out);
+}
+
+// Listing of path ("" for the current directory), read on first use
+static t_dirlist	*find_dir(const char *path)
+{
+	t_dirlist	*dir;
+	int			fd;
+
+	dir = glob_cache_find(path);
+	if (dir)
+		return (dir);
+	if (*path)
+		fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	else
+		fd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	dir = read_dirlist(fd, path);
+	if (fd >= 0)
+		close(fd);
+	return (glob_cache_add(dir));
+}
+
+// g->path (plen long) ends in a matched name; goes on with what follows
+static int	glob_next(t_glob *g, size_t plen, const char *rest)
+{
+	size_t		seps;
+	struct stat	st;
+
+	seps = 0;
+	while (rest[seps] == '/')
+		seps++;
+	if (plen + seps >= PATH_MAX)
+		return (1);
+	ft_memcpy(g->path + plen, rest, seps);
+	g->path[plen + seps] = '\0';
+	if (!rest[seps])
+	{
+		if (lstat(g->path, &st) != 0)
+			return (1);
+		return (argv_push(&g->out, ft_strdup(g->path)));
+	}
+	return (glob_walk(g, plen + seps, rest + seps));
+}
+
+// A directory is needed when more of the pattern follows the name
+static int	may_be_dir(t_dentry *ent)
+{
+	return (ent->type == DT_DIR || ent->type == DT_LNK
+		|| ent->type == DT_UNKNOWN);
+}
+
+// Narrows [lo, hi) of a sorted listing to the names that start with the
+// literal text the pattern starts with
+static void	prefix_range(t_dirlist *dir, t_pattern *pat, int *lo, int *hi)
+{
+	int		mid;
+	int		end;
+	size_t	n;
+
+	n = pat->ops[0].len;
+	end = *hi;
+	while (*lo < *hi)
+	{
+		mid = *lo + (*hi - *lo) / 2;
+		if (strncmp(dir->ents[mid].name, pat->ops[0].lit, n) < 0)
+			*lo = mid + 1;
+		else
+			*hi = mid;
+	}
+	*hi = end;
+	end = *lo;
+	while (end < *hi)
+	{
+		mid = end + (*hi - end) / 2;
+		if (strncmp(dir->ents[mid].name, pat->ops[0].lit, n) <= 0)
+			end = mid + 1;
+		else
+			*hi = mid;
+	}
+}
+
+// The entries of dir matched by pat, in byte order. A listing is sorted
+// when it is used a second time; until then only the matches are sorted,
+// so a lone "*.c" in a big directory does not pay for sorting all of it.
+static t_dentry	*matching_entries(t_dirlist *dir, t_pattern *pat,
+		int need_dir, int *n)
+{
+	t_dentry	*hits;
+	t_dentry	*ent;
+	int			lo;
+	int			hi;
+
+	if (dir->uses++ && !dir->sorted)
+		sort_dentries(dir->ents, dir->count);
+	dir->sorted |= (dir->uses > 1);
+	lo = 0;
+	hi = dir->count;
+	if (dir->sorted && pat->ops[0].op == PAT_LIT)
+		prefix_range(dir, pat, &lo, &hi);
+	*n = 0;
+	hits = malloc(sizeof(t_dentry) * (hi - lo + 1));
+	while (hits && lo < hi)
+	{
+		ent = &dir->ents[lo++];
+		if ((ent->name[0] == '.' && (pat->ops[0].op != PAT_LIT
+					|| pat->ops[0].lit[0] != '.'))
+			|| (need_dir && !may_be_dir(ent))
+			|| !pattern_match(pat, ent->name, ent->len))
+			continue ;
+		hits[(*n)++] = *ent;
+	}
+	if (hits && !dir->sorted)
+		sort_dentries(hits, *n);
+	return (hits);
+}
+
+static int	match_dir(t_glob *g, t_pattern *pat, size_t plen, const char *rest)
+{
+	t_dirlist	*dir;
+	t_dentry	*hits;
+	int			n;
+	int			i;
+	int			ok;
+
+	dir = find_dir(g->path);
+	if (!dir)
+		return (0);
+	hits = matching_entries(dir, pat, *rest != '\0', &n);
+	ok = (hits != NULL);
+	i = -1;
+	while (ok && ++i < n)
+	{
+		if (plen + hits[i].len >= PATH_MAX)
+			continue ;
+		ft_memcpy(g->path + plen, hits[i].name, hits[i].len + 1);
+		if (*rest)
+			ok = glob_next(g, plen + hits[i].len, rest);
+		else
+			ok = argv_push(&g->out, ft_strdup(g->path));
+	}
+	g->path[plen] = '\0';
+	free(hits);
+	return (ok);
+}
+
+// Expands the component at the start of rest below g->path
+int	glob_walk(t_glob *g, size_t plen, const char *rest)
+{
+	t_pattern	pat;
+	size_t		len;
+	char		*comp;
+	int			ok;
+
+	len = 0;
+	while (rest[len] && rest[len] != '/')
+		len += 1 + (rest[len] == '\\' && rest[len + 1] && rest[len + 1] != '/');
+	if (len == 2 && rest[0] == '*' && rest[1] == '*')
+		return (glob_globstar(g, plen, rest + len));
+	comp = ft_strndup(rest, len);
+	ok = (comp && pattern_compile(&pat, comp));
+	free(comp);
+	if (!ok)
+		return (0);
+	if (pat.magic)
+		ok = match_dir(g, &pat, plen, rest + len);
+	else if (plen + ft_strlen(pat.text) < PATH_MAX)
+	{
+		ft_memcpy(g->path + plen, pat.text, ft_strlen(pat.text) + 1);
+		ok = glob_next(g, plen + ft_strlen(pat.text), rest + len);
+	}
+	pattern_free(&pat);
+	return (ok);
+}
+
+static int	cmp_str(const void *a, const void *b)
+{
+	return (ft_strcmp(*(char *const *)a, *(char *const *)b));
+}
+
+// Sorted names matched by pattern, or NULL if there are none (the word
+// is then kept as it is)
+char	**glob_word(const char *pattern, t_env *env_list)
+{
+	t_glob	*g;
+	char	**names;
+	int		i;
+
+	g = ft_calloc(1, sizeof(t_glob));
+	if (!g)
+		return (NULL);
+	g->env = env_list;
+	if (!glob_walk(g, 0, pattern) || !g->out.count)
+	{
+		free_str_array(g->out.v);
+		free(g);
+		return (NULL);
+	}
+	i = 0;
+	while (i + 1 < g->out.count && ft_strcmp(g->out.v[i], g->out.v[i + 1]) < 0)
+		i++;
+	if (i + 1 < g->out.count)
+		qsort(g->out.v, g->out.count, sizeof(char *), cmp_str);
+	names = g->out.v;
+	free(g);
+	return (names);
+}
@@ -0,0 +1,138 @@
+#include "minishell.h"
+
+// Sorts directory listings in byte order. The names are compared 8 bytes
+// at a time: a stable LSD radix sort on those bytes, skipping the passes
+// where every name has the same byte (the common prefix of "file00123"
+// style names costs nothing), then the runs that still tie are sorted on
+// their next 8 bytes. Short runs use insertion sort.
+
+static unsigned long	key_at(const t_dentry *ent, size_t depth)
+{
+	unsigned long	key;
+	size_t			i;
+
+	key = 0;
+	i = 0;
+	while (i < 8 && depth + i < ent->len)
+	{
+		key |= (unsigned long)(unsigned char)ent->name[depth + i]
+			<< (56 - 8 * i);
+		i++;
+	}
+	return (key);
+}
+
+static void	insertion_sort(t_dentry *ents, int n, size_t depth)
+{
+	t_dentry	cur;
+	int			i;
+	int			j;
+
+	i = 1;
+	while (i < n)
+	{
+		cur = ents[i];
+		j = i - 1;
+		while (j >= 0 && strcmp(ents[j].name + depth, cur.name + depth) > 0)
+		{
+			ents[j + 1] = ents[j];
+			j--;
+		}
+		ents[j + 1] = cur;
+		i++;
+	}
+}
+
+// One counting pass on byte b of the keys, from src into dst
+static void	radix_pass(t_dentry *src, t_dentry *dst, int n, unsigned int *count)
+{
+	unsigned int	pos[256];
+	unsigned int	sum;
+	int				i;
+
+	sum = 0;
+	i = -1;
+	while (++i < 256)
+	{
+		pos[i] = sum;
+		sum += count[i];
+	}
+	i = -1;
+	while (++i < n)
+		dst[pos[(src[i].key >> count[256]) & 255]++] = src[i];
+}
+
+static void	radix_by_key(t_dentry *ents, t_dentry *tmp, int n)
+{
+	unsigned int	count[8][257];
+	t_dentry		*swap;
+	t_dentry		*src;
+	int				b;
+	int				i;
+
+	memset(count, 0, sizeof(count));
+	i = -1;
+	while (++i < n)
+	{
+		b = -1;
+		while (++b < 8)
+			count[b][(ents[i].key >> (8 * b)) & 255]++;
+	}
+	src = ents;
+	b = -1;
+	while (++b < 8)
+	{
+		count[b][256] = 8 * b;
+		if (count[b][(src[0].key >> (8 * b)) & 255] == (unsigned int)n)
+			continue ;
+		radix_pass(src, tmp, n, count[b]);
+		swap = src;
+		src = tmp;
+		tmp = swap;
+	}
+	if (src != ents)
+		memcpy(ents, src, sizeof(t_dentry) * n);
+}
+
+// Sorts ents, whose names all share their first depth bytes
+static void	sort_range(t_dentry *ents, t_dentry *tmp, int n, size_t depth)
+{
+	size_t	longest;
+	int		i;
+	int		j;
+
+	if (n < 16)
+		return (insertion_sort(ents, n, depth));
+	i = -1;
+	while (++i < n)
+		ents[i].key = key_at(&ents[i], depth);
+	radix_by_key(ents, tmp, n);
+	i = 0;
+	while (i < n)
+	{
+		longest = ents[i].len;
+		j = i + 1;
+		while (j < n && ents[j].key == ents[i].key)
+		{
+			if (ents[j].len > longest)
+				longest = ents[j].len;
+			j++;
+		}
+		if (j - i > 1 && longest > depth + 8)
+			sort_range(ents + i, tmp, j - i, depth + 8);
+		i = j;
+	}
+}
+
+void	sort_dentries(t_dentry *ents, int n)
+{
+	t_dentry	*tmp;
+
+	if (n < 16)
+		return (insertion_sort(ents, n, 0));
+	tmp = malloc(sizeof(t_dentry) * n);
+	if (!tmp)
+		return (insertion_sort(ents, n, 0));
+	sort_range(ents, tmp, n, 0);
+	free(tmp);
+}
@@ -0,0 +1,305 @@
+#include "minishell.h"
+
+// "**" as a whole component matches any number of directories, so
+// "**/*.proto" finds every .proto below the current directory. The tree
+// is read by GLOBSTAR_THREADS threads (default: one per CPU, at most
+// GLOB_MAX_THREADS). Each thread owns a queue of directories relative to
+// the root: it takes the newest one itself and, when it runs dry, steals
+// the oldest one of another thread, which is usually the biggest subtree
+// left. Directories are opened with openat() on the root descriptor and
+// read through read_dirlist(); only DT_UNKNOWN entries cost an fstatat().
+// Hidden directories and symbolic links to directories are not entered,
+// though "**/" lists the latter, and "dir/**" includes "dir/" itself,
+// like bash with globstar set.
+// When the walk is done the listings are sorted on their path and put in
+// the glob cache, and the rest of the pattern is matched below each
+// directory in that order, so the result does not depend on scheduling.
+
+static int	glob_threads(t_env *env_list)
+{
+	char	*val;
+	long	n;
+
+	val = get_env_value(env_list, "GLOBSTAR_THREADS");
+	n = 0;
+	if (val && ft_isdigit(*val) && ft_strlen(val) < 4)
+		n = ft_atoi(val);
+	if (n < 1)
+		n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1)
+		n = 1;
+	if (n > GLOB_MAX_THREADS)
+		n = GLOB_MAX_THREADS;
+	return (n);
+}
+
+static int	wq_push(t_wqueue *q, char *rel)
+{
+	char	**grown;
+	int		ok;
+
+	ok = (rel != NULL);
+	pthread_mutex_lock(&q->lock);
+	if (ok && q->tail == q->cap && q->head > 0)
+	{
+		memmove(q->items, q->items + q->head,
+			sizeof(char *) * (q->tail - q->head));
+		q->tail -= q->head;
+		q->head = 0;
+	}
+	if (ok && q->tail == q->cap)
+	{
+		grown = realloc(q->items, sizeof(char *) * (q->cap * 2 + 16));
+		ok = (grown != NULL);
+		if (ok)
+			q->items = grown;
+		if (ok)
+			q->cap = q->cap * 2 + 16;
+	}
+	if (ok)
+		q->items[q->tail++] = rel;
+	pthread_mutex_unlock(&q->lock);
+	return (ok);
+}
+
+// The owner takes the newest directory, a thief the oldest
+static char	*wq_take(t_wqueue *q, int steal)
+{
+	char	*rel;
+
+	rel = NULL;
+	pthread_mutex_lock(&q->lock);
+	if (q->tail > q->head && steal)
+		rel = q->items[q->head++];
+	else if (q->tail > q->head)
+		rel = q->items[--q->tail];
+	if (q->head == q->tail)
+	{
+		q->head = 0;
+		q->tail = 0;
+	}
+	pthread_mutex_unlock(&q->lock);
+	return (rel);
+}
+
+static int	is_subdir(int fd, t_dentry *ent)
+{
+	struct stat	st;
+
+	if (ent->name[0] == '.')
+		return (0);
+	if (ent->type == DT_DIR)
+		return (1);
+	if (ent->type != DT_UNKNOWN)
+		return (0);
+	return (fstatat(fd, ent->name, &st, AT_SYMLINK_NOFOLLOW) == 0
+		&& S_ISDIR(st.st_mode));
+}
+
+// Reads one directory and queues its subdirectories
+static void	walk_dir(t_wthread *t, char *rel)
+{
+	t_walker	*w;
+	t_dirlist	*dir;
+	char		*path;
+	int			fd;
+	int			i;
+
+	w = t->walker;
+	fd = w->root_fd;
+	if (*rel)
+		fd = openat(w->root_fd, rel, O_RDONLY | O_DIRECTORY | O_NOFOLLOW
+				| O_CLOEXEC);
+	path = ft_strjoin(w->base, rel);
+	dir = NULL;
+	if (path && fd >= 0)
+		dir = read_dirlist(fd, path);
+	i = -1;
+	while (dir && ++i < dir->count)
+	{
+		if (!is_subdir(fd, &dir->ents[i]))
+			continue ;
+		__atomic_add_fetch(&w->pending, 1, __ATOMIC_ACQ_REL);
+		if (!wq_push(&w->queues[t->id],
+				ft_strjoin3(rel, dir->ents[i].name, "/")))
+			__atomic_sub_fetch(&w->pending, 1, __ATOMIC_ACQ_REL);
+	}
+	if (dir)
+		dir->next = t->found;
+	if (dir)
+		t->found = dir;
+	t->count += (dir != NULL);
+	if (fd >= 0 && fd != w->root_fd)
+		close(fd);
+	free(path);
+	free(rel);
+}
+
+static void	*walk_worker(void *arg)
+{
+	t_wthread	*t;
+	t_walker	*w;
+	char		*rel;
+	int			i;
+
+	t = arg;
+	w = t->walker;
+	while (__atomic_load_n(&w->pending, __ATOMIC_ACQUIRE) > 0)
+	{
+		rel = wq_take(&w->queues[t->id], 0);
+		i = 1;
+		while (!rel && i < w->nthreads)
+			rel = wq_take(&w->queues[(t->id + i++) % w->nthreads], 1);
+		if (!rel)
+		{
+			sched_yield();
+			continue ;
+		}
+		walk_dir(t, rel);
+		__atomic_sub_fetch(&w->pending, 1, __ATOMIC_ACQ_REL);
+	}
+	return (NULL);
+}
+
+static void	run_walkers(t_walker *w, t_wthread *threads)
+{
+	int	i;
+
+	i = -1;
+	while (++i < w->nthreads)
+	{
+		threads[i].walker = w;
+		threads[i].id = i;
+		pthread_mutex_init(&w->queues[i].lock, NULL);
+	}
+	w->pending = 1;
+	if (!wq_push(&w->queues[0], ft_strdup("")))
+		w->pending = 0;
+	i = 0;
+	while (++i < w->nthreads)
+		threads[i].started = !pthread_create(&threads[i].tid, NULL,
+				walk_worker, &threads[i]);
+	walk_worker(&threads[0]);
+	while (--i > 0)
+		if (threads[i].started)
+			pthread_join(threads[i].tid, NULL);
+	i = -1;
+	while (++i < w->nthreads)
+	{
+		pthread_mutex_destroy(&w->queues[i].lock);
+		free(w->queues[i].items);
+	}
+}
+
+static int	cmp_dirlist(const void *a, const void *b)
+{
+	return (ft_strcmp((*(t_dirlist *const *)a)->path,
+			(*(t_dirlist *const *)b)->path));
+}
+
+// Moves the listings found by the threads into the glob cache and
+// returns them sorted on their path
+static t_dirlist	**collect_dirs(t_walker *w, t_wthread *threads, int *n)
+{
+	t_dirlist	**dirs;
+	t_dirlist	*dir;
+	int			i;
+
+	*n = 0;
+	i = -1;
+	while (++i < w->nthreads)
+		*n += threads[i].count;
+	dirs = malloc(sizeof(t_dirlist *) * (*n + 1));
+	*n = 0;
+	i = -1;
+	while (++i < w->nthreads)
+	{
+		while (threads[i].found)
+		{
+			dir = threads[i].found;
+			threads[i].found = dir->next;
+			dir->next = NULL;
+			if (dirs)
+				dirs[(*n)++] = dir;
+			else
+				free_dirlist(dir);
+		}
+	}
+	if (!dirs)
+		return (NULL);
+	qsort(dirs, *n, sizeof(t_dirlist *), cmp_dirlist);
+	i = -1;
+	while (++i < *n)
+		dirs[i] = glob_cache_add(dirs[i]);
+	return (dirs);
+}
+
+// Every directory below base, base included, sorted on its path
+static t_dirlist	**walk_tree(const char *base, int nthreads, int *n)
+{
+	t_walker	w;
+	t_wthread	*threads;
+	t_dirlist	**dirs;
+
+	*n = 0;
+	ft_memset(&w, 0, sizeof(t_walker));
+	w.base = base;
+	w.nthreads = nthreads;
+	if (*base)
+		w.root_fd = open(base, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	else
+		w.root_fd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (w.root_fd < 0)
+		return (ft_calloc(1, sizeof(t_dirlist *)));
+	w.queues = ft_calloc(nthreads, sizeof(t_wqueue));
+	threads = ft_calloc(nthreads, sizeof(t_wthread));
+	dirs = NULL;
+	if (w.queues && threads)
+	{
+		run_walkers(&w, threads);
+		dirs = collect_dirs(&w, threads, n);
+	}
+	free(w.queues);
+	free(threads);
+	close(w.root_fd);
+	return (dirs);
+}
+
+// rest follows a "**" component that ends at g->path + plen
+int	glob_globstar(t_glob *g, size_t plen, const char *rest)
+{
+	t_dirlist	**dirs;
+	size_t		seps;
+	size_t		len;
+	int			n;
+	int			i;
+	int			ok;
+
+	while (rest[0] == '/' && !ft_strncmp(rest + 1, "**", 2)
+		&& (rest[3] == '/' || !rest[3]))
+		rest += 3;
+	seps = 0;
+	while (rest[seps] == '/')
+		seps++;
+	dirs = walk_tree(g->path, glob_threads(g->env), &n);
+	ok = (dirs != NULL);
+	i = -1;
+	while (ok && ++i < n)
+	{
+		if (!dirs[i] || ft_strlen(dirs[i]->path) >= PATH_MAX)
+			continue ;
+		len = ft_strlen(dirs[i]->path);
+		ft_memcpy(g->path, dirs[i]->path, len + 1);
+		if (!rest[seps] && len == plen && plen)
+			ok = argv_push(&g->out, ft_strdup(g->path));
+		if (ok && rest[seps])
+			ok = glob_walk(g, len, rest + seps);
+		else if (ok && seps)
+			ok = glob_walk(g, len, "*/");
+		else if (ok)
+			ok = glob_walk(g, len, "*");
+	}
+	g->path[plen] = '\0';
+	free(dirs);
+	return (ok);
+}
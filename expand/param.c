@@ -0,0 +1,521 @@
+#include "minishell.h"
+
+// ${...} parameter expansion: ${x}, ${#x}, ${x:-w} ${x:=w} ${x:+w} ${x:?w}
+// (and the forms without ':', which only test for unset), ${x#p} ${x##p}
+// ${x%p} ${x%%p}, ${x/p/r} ${x//p/r} ${x/#p/r} ${x/%p/r} and ${x:off:len}.
+// The word after the operator is expanded first and its quotes removed;
+// patterns are compiled once with pattern_compile(), the matcher pathname
+// expansion uses, so trimming and replacing never leave the shell. A
+// pattern without * matches a single length, which is all that is tried.
+
+// Index just past the $( ) or ${ } at i, or i + 1
+static int	skip_expansion(const char *w, int i)
+{
+	if (w[i] == '$' && w[i + 1] == '(')
+		return (skip_dollar_paren(w, i));
+	if (w[i] == '$' && w[i + 1] == '{')
+		return (skip_dollar_brace(w, i));
+	return (i + 1);
+}
+
+// Index of the quote that closes the one at i, or the length of w
+static int	quoted_end(const char *w, int i)
+{
+	char	quote;
+
+	quote = w[i++];
+	while (w[i] && w[i] != quote)
+	{
+		if (quote == '\'')
+			i++;
+		else if (w[i] == '\\' && w[i + 1])
+			i += 2;
+		else
+			i = skip_expansion(w, i);
+	}
+	return (i);
+}
+
+// End of the unquoted run of w that starts at i
+static int	unquoted_end(const char *w, int i)
+{
+	while (w[i] && w[i] != '\'' && w[i] != '"'
+		&& !(w[i] == '\\' && w[i + 1]))
+		i = skip_expansion(w, i);
+	return (i);
+}
+
+// Index of the first c of w outside quotes and expansions, or its length
+static int	operand_split(const char *w, char c)
+{
+	int	i;
+
+	i = 0;
+	while (w[i] && w[i] != c)
+	{
+		if (w[i] == '\\' && w[i + 1])
+			i += 2;
+		else if (w[i] == '\'' || w[i] == '"')
+		{
+			i = quoted_end(w, i);
+			i += (w[i] != '\0');
+		}
+		else
+			i = skip_expansion(w, i);
+	}
+	return (i);
+}
+
+// One quoted part, backslashed character or unquoted run of w, expanded;
+// with pattern set the quoted parts are escaped so they match literally
+static char	*operand_part(const char *w, int *i, t_expand_data *data,
+		int pattern)
+{
+	char	*text;
+	char	*piece;
+	int		start;
+	int		quoted;
+
+	start = *i;
+	if (w[start] == '\\')
+	{
+		*i += 2;
+		return (ft_strndup(w + start + !pattern, 1 + pattern));
+	}
+	quoted = (w[start] == '\'' || w[start] == '"');
+	if (quoted)
+		*i = quoted_end(w, start);
+	else
+		*i = unquoted_end(w, start);
+	text = ft_strndup(w + start + quoted, *i - start - quoted);
+	*i += (quoted && w[*i]);
+	piece = text;
+	if (text && w[start] != '\'')
+	{
+		piece = expand_token_content(text, data->exit_code, 1,
+				data->env_list);
+		free(text);
+	}
+	if (!piece || !quoted || !pattern)
+		return (piece);
+	text = glob_escape(piece);
+	free(piece);
+	return (text);
+}
+
+// The first n bytes of the word after an operator, expanded and with
+// their quotes removed
+static char	*expand_operand(const char *w, size_t n, t_expand_data *data,
+		int pattern)
+{
+	char	*word;
+	char	*out;
+	char	*piece;
+	char	*joined;
+	int		i;
+
+	word = ft_strndup(w, n);
+	out = ft_strdup("");
+	i = 0;
+	while (word && out && word[i])
+	{
+		piece = operand_part(word, &i, data, pattern);
+		joined = NULL;
+		if (piece)
+			joined = ft_strjoin(out, piece);
+		free(piece);
+		free(out);
+		out = joined;
+	}
+	if (!word)
+	{
+		free(out);
+		out = NULL;
+	}
+	free(word);
+	return (out);
+}
+
+static char	*param_error(t_param *p, const char *what, const char *msg)
+{
+	ft_putstr_fd("minishell: ", 2);
+	if (what)
+		ft_putstr_fd((char *)what, 2);
+	else
+	{
+		ft_putstr_fd("${", 2);
+		ft_putstr_fd((char *)p->body, 2);
+		ft_putstr_fd("}", 2);
+	}
+	ft_putstr_fd(": ", 2);
+	ft_putstr_fd((char *)msg, 2);
+	ft_putstr_fd("\n", 2);
+	return (NULL);
+}
+
+// ${x-w} ${x=w} ${x+w} ${x?w}; with colon set an empty x counts as unset.
+// A failed ${x?w} makes a shell that is not interactive exit.
+static char	*param_default(t_param *p, char op, int colon, const char *word)
+{
+	char	*w;
+	int		missing;
+
+	missing = (!p->value || (colon && !*p->value));
+	if (op == '+' && missing)
+		return (ft_strdup(""));
+	if (op != '+' && !missing)
+		return (ft_strdup(p->value));
+	w = expand_operand(word, ft_strlen(word), p->data, 0);
+	if (!w || op == '-' || op == '+')
+		return (w);
+	if (op == '=' && is_valid_identifier(p->name)
+		&& set_env_value(&p->data->env_list, p->name, w))
+		return (w);
+	if (op == '=' && !is_valid_identifier(p->name))
+		param_error(p, p->name, "cannot assign in this way");
+	else if (op == '?' && *w)
+		param_error(p, p->name, w);
+	else if (op == '?')
+		param_error(p, p->name, "parameter null or not set");
+	if (op == '?')
+		fatal_error();
+	free(w);
+	return (NULL);
+}
+
+// Length of the longest or shortest match of pat at the start of the n
+// bytes of s, or -1
+static long	prefix_match(const t_pattern *pat, const char *s, size_t n,
+		int longest)
+{
+	size_t	j;
+	size_t	len;
+
+	if (!pat->stars)
+	{
+		if (pat->min_len <= n && pattern_match(pat, s, pat->min_len))
+			return (pat->min_len);
+		return (-1);
+	}
+	j = 0;
+	while (j <= n)
+	{
+		len = j;
+		if (longest)
+			len = n - j;
+		if (pattern_match(pat, s, len))
+			return (len);
+		j++;
+	}
+	return (-1);
+}
+
+// Where the longest or shortest match of pat that ends s starts, or -1
+static long	suffix_match(const t_pattern *pat, const char *s, size_t n,
+		int longest)
+{
+	size_t	j;
+	size_t	start;
+
+	if (!pat->stars)
+	{
+		if (pat->min_len <= n
+			&& pattern_match(pat, s + n - pat->min_len, pat->min_len))
+			return (n - pat->min_len);
+		return (-1);
+	}
+	j = 0;
+	while (j <= n)
+	{
+		start = n - j;
+		if (longest)
+			start = j;
+		if (pattern_match(pat, s + start, n - start))
+			return (start);
+		j++;
+	}
+	return (-1);
+}
+
+static int	compile_operand(t_pattern *pat, const char *w, size_t n,
+		t_expand_data *data)
+{
+	char	*src;
+	int		ok;
+
+	src = expand_operand(w, n, data, 1);
+	ok = (src && pattern_compile(pat, src));
+	free(src);
+	return (ok);
+}
+
+// ${x#p} ${x##p} ${x%p} ${x%%p}
+static char	*param_trim(t_param *p, const char *op)
+{
+	t_pattern	pat;
+	const char	*s;
+	int			longest;
+	long		cut;
+
+	longest = (op[1] == op[0]);
+	if (!compile_operand(&pat, op + 1 + longest,
+			ft_strlen(op + 1 + longest), p->data))
+		return (NULL);
+	s = p->value;
+	if (op[0] == '%')
+		cut = suffix_match(&pat, s, ft_strlen(s), longest);
+	else
+		cut = prefix_match(&pat, s, ft_strlen(s), longest);
+	pattern_free(&pat);
+	if (cut < 0)
+		return (ft_strdup(s));
+	if (op[0] == '%')
+		return (ft_strndup(s, cut));
+	return (ft_strdup(s + cut));
+}
+
+// Appends the n bytes of s to out
+static int	put_bytes(t_expand_data *out, const char *s, size_t n)
+{
+	int	i;
+
+	i = 0;
+	while ((size_t)i < n)
+		if (!process_regular_char((char *)s, &i, out))
+			return (0);
+	return (1);
+}
+
+// ${x/#p/r} ${x/%p/r}: replaces a match that starts or ends s
+static int	replace_anchored(t_param *p, const t_pattern *pat, char *rep,
+		t_expand_data *out)
+{
+	const char	*s;
+	size_t		n;
+	long		m;
+
+	s = p->value;
+	n = ft_strlen(s);
+	if (p->mode == '%')
+		m = suffix_match(pat, s, n, 1);
+	else
+		m = prefix_match(pat, s, n, 1);
+	if (m < 0)
+		return (put_bytes(out, s, n));
+	if (p->mode == '%')
+		return (put_bytes(out, s, m)
+			&& copy_var_value(out->res, out->len, out->max, rep));
+	return (copy_var_value(out->res, out->len, out->max, rep)
+		&& put_bytes(out, s + m, n - m));
+}
+
+// Copies the value to out with the first match of pat replaced by rep,
+// or every match with mode '/'; empty matches are not replaced
+static int	replace_matches(t_param *p, const t_pattern *pat, char *rep,
+		t_expand_data *out)
+{
+	const char	*s;
+	size_t		n;
+	size_t		i;
+	long		m;
+
+	if (p->mode == '#' || p->mode == '%')
+		return (replace_anchored(p, pat, rep, out));
+	s = p->value;
+	n = ft_strlen(s);
+	i = 0;
+	while (i < n)
+	{
+		m = prefix_match(pat, s + i, n - i, 1);
+		if (m <= 0 && !put_bytes(out, s + i, 1))
+			return (0);
+		if (m <= 0 && ++i)
+			continue ;
+		if (!copy_var_value(out->res, out->len, out->max, rep))
+			return (0);
+		i += m;
+		if (p->mode != '/')
+			break ;
+	}
+	return (put_bytes(out, s + i, n - i));
+}
+
+// ${x/p/r} ${x//p/r} ${x/#p/r} ${x/%p/r}
+static char	*param_replace(t_param *p, const char *op)
+{
+	t_pattern		pat;
+	t_expand_data	out;
+	char			*rep;
+	char			*res;
+	int				len;
+	int				max;
+	int				ok;
+
+	p->mode = 0;
+	if (op[1] == '/' || op[1] == '#' || op[1] == '%')
+		p->mode = *++op;
+	len = operand_split(op + 1, '/');
+	if (!compile_operand(&pat, op + 1, len, p->data))
+		return (NULL);
+	op += len + 1 + (op[len + 1] == '/');
+	rep = expand_operand(op, ft_strlen(op), p->data, 0);
+	len = 0;
+	max = 64;
+	res = malloc(max);
+	out.res = &res;
+	out.len = &len;
+	out.max = &max;
+	ok = (rep && res && replace_matches(p, &pat, rep, &out));
+	pattern_free(&pat);
+	free(rep);
+	if (!ok)
+	{
+		free(res);
+		return (NULL);
+	}
+	res[len] = '\0';
+	return (res);
+}
+
+// Evaluates the n bytes of w as an arithmetic expression
+static int	operand_arith(t_param *p, const char *w, size_t n,
+		long long *value)
+{
+	char	*expr;
+	int		ok;
+
+	expr = expand_operand(w, n, p->data, 0);
+	ok = (expr && eval_arith(expr, p->data->env_list, value));
+	free(expr);
+	return (ok);
+}
+
+// ${x:off} ${x:off:len}; a negative off counts from the end, and so does
+// a negative len
+static char	*param_substr(t_param *p, const char *op)
+{
+	const char	*s;
+	long long	off;
+	long long	count;
+	long long	len;
+	int			sep;
+
+	s = p->value;
+	len = ft_strlen(s);
+	sep = operand_split(op, ':');
+	count = len;
+	if (!operand_arith(p, op, sep, &off) || (op[sep]
+			&& !operand_arith(p, op + sep + 1, ft_strlen(op + sep + 1),
+				&count)))
+		return (NULL);
+	if (off < 0)
+		off += len;
+	if (off < 0 || off > len)
+		return (ft_strdup(""));
+	if (count < 0)
+		count += len - off;
+	if (count < 0)
+		return (param_error(p, op + sep + 1, "substring expression < 0"));
+	if (count > len - off)
+		count = len - off;
+	return (ft_strndup(s + off, count));
+}
+
+// Applies what follows the parameter name
+static char	*param_operator(t_param *p, const char *op)
+{
+	int	colon;
+
+	if (!*op)
+		return (ft_strdup(p->value ? p->value : ""));
+	colon = (op[0] == ':' && op[1] && ft_strchr("-=+?", op[1]));
+	if (op[colon] && ft_strchr("-=+?", op[colon]))
+		return (param_default(p, op[colon], colon, op + colon + 1));
+	if (!p->value)
+		p->value = ft_strdup("");
+	if (!p->value)
+		return (NULL);
+	if (op[0] == ':')
+		return (param_substr(p, op + 1));
+	if (op[0] == '#' || op[0] == '%')
+		return (param_trim(p, op));
+	if (op[0] == '/')
+		return (param_replace(p, op));
+	return (param_error(p, NULL, "bad substitution"));
+}
+
+// A variable name, a positional parameter ("1", "10") or one of ? # @ *
+static int	param_name_len(const char *s)
+{
+	int	i;
+
+	i = 0;
+	if (ft_isalpha(s[0]) || s[0] == '_')
+		while (is_valid_var_char(s[i]))
+			i++;
+	else if (ft_isdigit(s[0]))
+		while (ft_isdigit(s[i]))
+			i++;
+	else if (s[0] && ft_strchr("?#@*", s[0]))
+		i = 1;
+	return (i);
+}
+
+// The expansion of ${body}, or NULL after an error
+static char	*param_value(const char *body, t_expand_data *data)
+{
+	t_param	p;
+	char	*value;
+	char	*result;
+	int		length;
+	int		n;
+
+	ft_memset(&p, 0, sizeof(t_param));
+	p.body = body;
+	p.data = data;
+	length = (body[0] == '#' && body[1]);
+	n = param_name_len(body + length);
+	if (!n || (length && body[length + n]))
+		return (param_error(&p, NULL, "bad substitution"));
+	p.name = ft_strndup(body + length, n);
+	if (!p.name)
+		return (NULL);
+	value = NULL;
+	if (handle_special_var(p.name, data->exit_code, &value, data->env_list))
+		p.value = value;
+	else if (value)
+		p.value = ft_strdup(value);
+	result = NULL;
+	if (length && (p.value || !value))
+		result = ft_itoa(ft_strlen(p.value ? p.value : ""));
+	else if (p.value || !value)
+		result = param_operator(&p, body + n);
+	free(p.name);
+	free(p.value);
+	return (result);
+}
+
+// ${...}; *i is on the '{'. Returns 0 (failing the expansion) on errors.
+int	process_param_expansion(char *content, int *i, t_expand_data *data)
+{
+	int		end;
+	char	*body;
+	char	*value;
+	int		ok;
+
+	end = skip_dollar_brace(content, *i - 1);
+	if (content[end - 1] != '}')
+	{
+		ft_putstr_fd("minishell: bad substitution: missing `}'\n", 2);
+		return (0);
+	}
+	body = ft_strndup(content + *i + 1, end - *i - 2);
+	if (!body)
+		return (0);
+	value = param_value(body, data);
+	free(body);
+	ok = (value && copy_var_value(data->res, data->len, data->max, value));
+	free(value);
+	*i = end;
+	return (ok);
+}
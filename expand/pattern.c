@@ -0,0 +1,264 @@
+#include "minishell.h"
+#include <ctype.h>
+
+// Shell patterns (*, ?, [...]) compiled once into a list of steps, so that
+// matching many names against the same pattern does no parsing. Literal
+// runs are unescaped into pat->text and compared with memcmp(), a [...]
+// set becomes a 256-bit map. Matching is greedy with backtracking to the
+// last *, which is linear for one * and never worse than O(n*m). A
+// backslash quotes the next character; an unclosed [ is an ordinary [.
+
+static void	set_bit(unsigned char *set, unsigned char c)
+{
+	set[c >> 3] |= 1 << (c & 7);
+}
+
+// "[:alpha:]" and friends inside a set; returns the length used, or 0
+static int	add_char_class(unsigned char *set, const char *s)
+{
+	static const char	*names[] = {"alpha", "digit", "alnum", "upper",
+		"lower", "space", "blank", "punct", "xdigit", "print", "graph",
+		"cntrl", NULL};
+	static int			(*tests[])(int) = {isalpha, isdigit, isalnum, isupper,
+		islower, isspace, isblank, ispunct, isxdigit, isprint, isgraph,
+		iscntrl};
+	size_t				len;
+	int					i;
+	int					c;
+
+	i = -1;
+	while (names[++i])
+	{
+		len = ft_strlen(names[i]);
+		if (s[0] == '[' && s[1] == ':' && !ft_strncmp(s + 2, names[i], len)
+			&& s[len + 2] == ':' && s[len + 3] == ']')
+		{
+			c = -1;
+			while (++c < 256)
+				if (tests[i](c))
+					set_bit(set, c);
+			return (len + 4);
+		}
+	}
+	return (0);
+}
+
+// Parses the set that starts after '['; returns the length up to and
+// including ']', or 0 if the set is not closed
+static int	compile_set(t_patop *op, const char *s)
+{
+	int				i;
+	int				negate;
+	int				used;
+	unsigned char	lo;
+	int				c;
+
+	ft_memset(op->set, 0, sizeof(op->set));
+	negate = (s[0] == '!' || s[0] == '^');
+	i = negate;
+	while (s[i] && (s[i] != ']' || i == negate))
+	{
+		used = add_char_class(op->set, s + i);
+		if (used)
+		{
+			i += used;
+			continue ;
+		}
+		if (s[i] == '\\' && s[i + 1])
+			i++;
+		lo = s[i++];
+		c = lo;
+		if (s[i] == '-' && s[i + 1] && s[i + 1] != ']')
+		{
+			i += 1 + (s[i + 1] == '\\' && s[i + 2]);
+			while (c <= (unsigned char)s[i])
+				set_bit(op->set, c++);
+			i++;
+		}
+		set_bit(op->set, lo);
+	}
+	if (!s[i])
+		return (0);
+	c = -1;
+	while (negate && ++c < 32)
+		op->set[c] = ~op->set[c];
+	op->op = PAT_SET;
+	return (i + 1);
+}
+
+// Adds c to the literal run that ends the pattern, or starts a new one
+static void	add_literal(t_pattern *pat, char **out, char c)
+{
+	t_patop	*last;
+
+	last = NULL;
+	if (pat->count)
+		last = &pat->ops[pat->count - 1];
+	if (!last || last->op != PAT_LIT)
+	{
+		last = &pat->ops[pat->count++];
+		last->op = PAT_LIT;
+		last->lit = *out;
+		last->len = 0;
+	}
+	*(*out)++ = c;
+	last->len++;
+	pat->min_len++;
+}
+
+static int	compile_step(t_pattern *pat, const char *src, int i, char **out)
+{
+	t_patop	*op;
+	int		used;
+
+	op = &pat->ops[pat->count];
+	if (src[i] == '*')
+	{
+		if (!pat->count || pat->ops[pat->count - 1].op != PAT_STAR)
+			pat->ops[pat->count++].op = PAT_STAR;
+		return (1);
+	}
+	if (src[i] == '?' || src[i] == '[')
+	{
+		op->op = PAT_ANY;
+		used = 1;
+		if (src[i] == '[')
+			used = compile_set(op, src + i + 1) + 1;
+		if (used > 1 || src[i] == '?')
+		{
+			pat->count++;
+			pat->min_len++;
+			return (used);
+		}
+	}
+	if (src[i] == '\\' && src[i + 1])
+	{
+		add_literal(pat, out, src[i + 1]);
+		return (2);
+	}
+	add_literal(pat, out, src[i]);
+	return (1);
+}
+
+// Compiles src; returns 0 if out of memory
+int	pattern_compile(t_pattern *pat, const char *src)
+{
+	size_t	len;
+	char	*out;
+	int		i;
+
+	ft_memset(pat, 0, sizeof(t_pattern));
+	len = ft_strlen(src);
+	pat->ops = malloc(sizeof(t_patop) * (len + 1));
+	pat->text = malloc(len + 1);
+	if (!pat->ops || !pat->text)
+	{
+		pattern_free(pat);
+		return (0);
+	}
+	out = pat->text;
+	i = 0;
+	while (src[i])
+		i += compile_step(pat, src, i, &out);
+	*out = '\0';
+	i = -1;
+	while (++i < pat->count)
+	{
+		if (pat->ops[i].op != PAT_LIT)
+			pat->magic = 1;
+		pat->stars += (pat->ops[i].op == PAT_STAR);
+	}
+	return (1);
+}
+
+// Whether s has an unquoted *, ? or [
+int	pattern_is_magic(const char *s)
+{
+	while (*s)
+	{
+		if (*s == '\\' && s[1])
+			s++;
+		else if (*s == '*' || *s == '?' || *s == '[')
+			return (1);
+		s++;
+	}
+	return (0);
+}
+
+void	pattern_free(t_pattern *pat)
+{
+	free(pat->ops);
+	free(pat->text);
+	pat->ops = NULL;
+	pat->text = NULL;
+	pat->count = 0;
+}
+
+static int	step_matches(const t_patop *op, const char *s, size_t n)
+{
+	unsigned char	c;
+
+	if (op->op == PAT_LIT)
+		return (n >= op->len && !ft_memcmp(s, op->lit, op->len));
+	if (!n)
+		return (0);
+	c = *s;
+	if (op->op == PAT_SET)
+		return ((op->set[c >> 3] >> (c & 7)) & 1);
+	return (1);
+}
+
+// A pattern ending in "*literal" can only match names that end in it,
+// which rejects most names without backtracking
+static int	tail_matches(const t_pattern *pat, const char *s, size_t n)
+{
+	const t_patop	*last;
+
+	if (pat->count < 2 || pat->ops[pat->count - 2].op != PAT_STAR)
+		return (1);
+	last = &pat->ops[pat->count - 1];
+	return (last->op != PAT_LIT
+		|| !ft_memcmp(s + n - last->len, last->lit, last->len));
+}
+
+// Whether the first n bytes of s are matched by the whole pattern
+int	pattern_match(const t_pattern *pat, const char *s, size_t n)
+{
+	int		i;
+	int		star;
+	size_t	pos;
+	size_t	star_pos;
+
+	if (n < pat->min_len || !tail_matches(pat, s, n))
+		return (0);
+	i = 0;
+	pos = 0;
+	star = -1;
+	star_pos = 0;
+	while (1)
+	{
+		if (i < pat->count && pat->ops[i].op == PAT_STAR)
+		{
+			star = ++i;
+			star_pos = pos;
+			if (star == pat->count)
+				return (1);
+			continue ;
+		}
+		if (i == pat->count && pos == n)
+			return (1);
+		if (i < pat->count && step_matches(&pat->ops[i], s + pos, n - pos))
+		{
+			if (pat->ops[i].op == PAT_LIT)
+				pos += pat->ops[i].len;
+			else
+				pos++;
+			i++;
+			continue ;
+		}
+		if (star < 0 || star_pos >= n)
+			return (0);
+		i = star;
+		pos = ++star_pos;
+	}
+}
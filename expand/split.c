@@ -0,0 +1,275 @@
+#include "minishell.h"
+
+// Field splitting. The expander records which bytes of an unquoted token
+// came from expansions (t_elem.split); only those are cut at IFS
+// characters, the rest of the word sticks to the field next to it. A run
+// of IFS whitespace is one delimiter and is dropped at the ends of a word,
+// every other IFS character ends a field, possibly an empty one, and a
+// word that expands to nothing unquoted gives no argument at all. With
+// the default IFS, delimiters are looked for 8 bytes at a time, and a
+// field that lies inside one expansion and has nothing left to expand is
+// copied once, straight into the argument vector. Braces, commas and dots
+// that came from expansions are escaped in the pattern copy of the word,
+// so brace expansion only sees those of the word's own text.
+
+#define ONES 0x0101010101010101ULL
+#define HIGHS 0x8080808080808080ULL
+
+// How the bytes given to word_append() came about
+#define PART_TEXT 0
+#define PART_QUOTED 1
+#define PART_EXPANDED 2
+
+static void	ifs_init(t_ifs *ifs, t_env *env_list)
+{
+	const char	*s;
+
+	s = get_env_value(env_list, "IFS");
+	if (!s)
+		s = " \t\n";
+	ft_memset(ifs->kind, 0, sizeof(ifs->kind));
+	ifs->plain = !ft_strcmp(s, " \t\n");
+	ifs->none = !*s;
+	while (*s)
+	{
+		if (*s == ' ' || *s == '\t' || *s == '\n')
+			ifs->kind[(unsigned char)*s] = IFS_SPACE;
+		else
+			ifs->kind[(unsigned char)*s] = IFS_OTHER;
+		s++;
+	}
+}
+
+// Whether one of the 8 bytes of w is a space, a tab or a newline. The
+// zero-byte test only misfires next to a byte that does match.
+static int	has_default_ifs(uint64_t w)
+{
+	uint64_t	sp;
+	uint64_t	tab;
+	uint64_t	nl;
+
+	sp = w ^ (ONES * ' ');
+	tab = w ^ (ONES * '\t');
+	nl = w ^ (ONES * '\n');
+	return ((((sp - ONES) & ~sp) | ((tab - ONES) & ~tab)
+			| ((nl - ONES) & ~nl)) & HIGHS) != 0;
+}
+
+// Index of the first IFS character of the n bytes of s, or n
+static size_t	ifs_next(const t_ifs *ifs, const char *s, size_t n)
+{
+	uint64_t	w;
+	size_t		i;
+
+	i = 0;
+	while (ifs->plain && i + 8 <= n)
+	{
+		memcpy(&w, s + i, 8);
+		if (has_default_ifs(w))
+			break ;
+		i += 8;
+	}
+	while (i < n && !ifs->kind[(unsigned char)s[i]])
+		i++;
+	return (i);
+}
+
+// Makes room for need bytes in the buffer at *buf, doubling its size
+static int	buf_reserve(char **buf, size_t *cap, size_t need)
+{
+	char	*out;
+	size_t	size;
+
+	if (need <= *cap)
+		return (1);
+	size = 32;
+	while (size < need)
+		size *= 2;
+	out = realloc(*buf, size);
+	if (!out)
+		return (0);
+	*buf = out;
+	*cap = size;
+	return (1);
+}
+
+// Adds the n bytes of s to the pattern copy, escaping those the way they
+// came about makes literal: every special character of quoted ones, and
+// the ones brace expansion looks at ({ , } and the dots of {1..3}) of
+// expanded ones
+static int	pattern_append(t_word *w, const char *s, size_t n, int how)
+{
+	const char	*special;
+	size_t		i;
+
+	if (!buf_reserve(&w->pattern, &w->pat_cap, w->pat_len + 2 * n + 1))
+		return (0);
+	special = "";
+	if (how == PART_QUOTED)
+		special = "\\*?[]{},";
+	else if (how == PART_EXPANDED)
+		special = "{,}.";
+	i = 0;
+	while (i < n)
+	{
+		if (*special && ft_strchr(special, s[i]))
+			w->pattern[w->pat_len++] = '\\';
+		w->pattern[w->pat_len++] = s[i++];
+	}
+	w->pattern[w->pat_len] = '\0';
+	return (1);
+}
+
+// Adds n bytes of s to the field being built, in place; quoted bytes are
+// escaped in its pattern copy, so only an unquoted *, ? or [ makes it a
+// pattern, and so are the characters of expanded ones that brace
+// expansion looks at
+static int	word_append(t_word *w, const char *s, size_t n, int how)
+{
+	size_t	i;
+
+	if (!n && how != PART_QUOTED)
+		return (1);
+	w->started = 1;
+	w->pending = 0;
+	if (!buf_reserve(&w->text, &w->text_cap, w->text_len + n + 1))
+		return (0);
+	ft_memcpy(w->text + w->text_len, s, n);
+	w->text_len += n;
+	w->text[w->text_len] = '\0';
+	if (!pattern_append(w, s, n, how))
+		return (0);
+	i = 0;
+	while (how != PART_QUOTED && i < n && !w->magic)
+	{
+		w->magic = (s[i] == '*' || s[i] == '?' || s[i] == '[');
+		i++;
+	}
+	return (1);
+}
+
+// Ends the field being built at the IFS character c
+static int	field_delim(t_word *w, unsigned char c)
+{
+	int	ok;
+
+	if (w->ifs.kind[c] == IFS_SPACE)
+	{
+		if (!w->started)
+			return (1);
+		w->pending = 1;
+		return (word_push(w));
+	}
+	ok = 1;
+	if (w->started || !w->pending)
+		ok = word_push(w);
+	w->pending = 0;
+	return (ok);
+}
+
+// Whether a field has nothing left for brace or pathname expansion
+static int	is_plain(const char *s, size_t n)
+{
+	size_t	i;
+
+	i = 0;
+	while (i < n)
+	{
+		if (s[i] == '*' || s[i] == '?' || s[i] == '[' || s[i] == '{')
+			return (0);
+		i++;
+	}
+	return (1);
+}
+
+// Cuts the n bytes of one expansion at IFS characters
+static int	split_span(t_word *w, const char *s, size_t n)
+{
+	size_t	i;
+	size_t	end;
+	int		ok;
+
+	if (w->ifs.none)
+		return (word_append(w, s, n, PART_EXPANDED));
+	ok = 1;
+	i = 0;
+	while (ok > 0 && i < n)
+	{
+		end = i + ifs_next(&w->ifs, s + i, n - i);
+		if (end < n && end > i && !w->started && is_plain(s + i, end - i))
+		{
+			ok = argv_push(w->args, ft_strndup(s + i, end - i));
+			w->pending = (w->ifs.kind[(unsigned char)s[end]] == IFS_SPACE);
+			if (ok && w->limit && w->args->bytes > w->limit)
+				ok = -1;
+		}
+		else
+		{
+			ok = word_append(w, s + i, end - i, PART_EXPANDED);
+			if (ok > 0 && end < n)
+				ok = field_delim(w, s[end]);
+		}
+		i = end + 1;
+	}
+	return (ok);
+}
+
+// A double-quoted token where "$@" gave several parameters: each of the
+// spaces between them ends a field
+static int	add_quoted_fields(t_word *w, const char *s, const int *at)
+{
+	int	pos;
+	int	ok;
+
+	ok = 1;
+	pos = 0;
+	while (ok > 0 && *at >= 0)
+	{
+		ok = word_append(w, s + pos, *at - pos, PART_QUOTED);
+		if (ok > 0)
+			ok = word_push(w);
+		pos = *at++ + 1;
+	}
+	if (ok > 0)
+		ok = word_append(w, s + pos, ft_strlen(s + pos), PART_QUOTED);
+	return (ok);
+}
+
+// Adds one token to the word: quoted tokens whole, or cut where "$@" put
+// one parameter after another, unquoted ones cut into fields where their
+// expansions have IFS characters. Returns -1 when the arguments outgrow
+// w->limit.
+int	word_add_part(t_word *w, t_elem *part)
+{
+	const char	*s;
+	const int	*span;
+	int			pos;
+	int			ok;
+
+	s = part->content;
+	if (part->state != GENERAL && part->fields && !w->literal)
+		return (add_quoted_fields(w, s, part->fields));
+	if (part->state != GENERAL || !part->split || w->literal)
+	{
+		ok = word_append(w, s, ft_strlen(s), part->state != GENERAL);
+		w->started |= w->literal;
+		return (ok);
+	}
+	if (!w->has_ifs)
+		ifs_init(&w->ifs, w->data->n_env);
+	w->has_ifs = 1;
+	ok = 1;
+	pos = 0;
+	span = part->split;
+	while (ok > 0 && span[0] >= 0)
+	{
+		ok = word_append(w, s + pos, span[0] - pos, PART_TEXT);
+		if (ok > 0)
+			ok = split_span(w, s + span[0], span[1] - span[0]);
+		pos = span[1];
+		span += 2;
+	}
+	if (ok > 0)
+		ok = word_append(w, s + pos, ft_strlen(s + pos), PART_TEXT);
+	return (ok);
+}
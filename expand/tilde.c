@@ -0,0 +1,192 @@
+#include "minishell.h"
+#include <pwd.h>
+
+// Tilde expansion. An unquoted "~" at the start of a word, or right after
+// the '=' or a ':' of an assignment-like word, is replaced up to the next
+// '/': "~" by $HOME, "~+" by $PWD, "~-" by $OLDPWD and "~user" by that
+// user's home directory. It runs on the tokens before any other
+// expansion; the directory goes into a token of its own, quoted, so it is
+// neither expanded again, split nor globbed. A prefix that cannot be
+// resolved is left as it is.
+// Home directories come from getpwnam(), which may go through NSS to a
+// slow directory service, so every answer, unknown users included, is
+// kept for TILDE_CACHE_TTL seconds and a name is looked up once per TTL.
+
+static t_tildent	*g_tilde_table[TILDE_CACHE_SIZE];
+
+static unsigned long	hash_user(const char *s, size_t n)
+{
+	unsigned long	h;
+
+	h = 5381;
+	while (n--)
+		h = h * 33 + (unsigned char)*s++;
+	return (h % TILDE_CACHE_SIZE);
+}
+
+// Looks the user up and fills ent; "" is the user running the shell
+static void	lookup_user(t_tildent *ent)
+{
+	struct passwd	*pw;
+
+	stats_count(STAT_TILDE_LOOKUPS, 1);
+	if (*ent->name)
+		pw = getpwnam(ent->name);
+	else
+		pw = getpwuid(getuid());
+	free(ent->dir);
+	ent->dir = NULL;
+	if (pw && pw->pw_dir)
+		ent->dir = ft_strdup(pw->pw_dir);
+	ent->stamp = now_usec();
+}
+
+// Home directory of the n bytes of name, or NULL for an unknown user
+static const char	*user_home(const char *name, size_t n)
+{
+	t_tildent	**link;
+	t_tildent	*ent;
+
+	link = &g_tilde_table[hash_user(name, n)];
+	while (*link && (ft_strlen((*link)->name) != n
+			|| ft_strncmp((*link)->name, name, n)))
+		link = &(*link)->next;
+	ent = *link;
+	if (ent && now_usec() - ent->stamp < TILDE_CACHE_TTL * 1000000L)
+	{
+		stats_count(STAT_TILDE_HITS, 1);
+		return (ent->dir);
+	}
+	if (!ent)
+	{
+		ent = ft_calloc(1, sizeof(t_tildent));
+		if (ent)
+			ent->name = ft_strndup(name, n);
+		if (!ent || !ent->name)
+		{
+			free(ent);
+			return (NULL);
+		}
+		*link = ent;
+	}
+	lookup_user(ent);
+	return (ent->dir);
+}
+
+// What the tilde prefix "~" + the n bytes of name stands for, or NULL
+static const char	*tilde_dir(const char *name, size_t n, t_env *env_list)
+{
+	const char	*dir;
+	size_t		i;
+
+	if (n == 0)
+	{
+		dir = get_env_value(env_list, "HOME");
+		if (dir)
+			return (dir);
+	}
+	if (n == 1 && (name[0] == '+' || name[0] == '-'))
+	{
+		if (name[0] == '+')
+			return (get_env_value(env_list, "PWD"));
+		return (get_env_value(env_list, "OLDPWD"));
+	}
+	i = 0;
+	while (i < n && !ft_strchr("$\\`", name[i]))
+		i++;
+	if (i < n)
+		return (NULL);
+	return (user_home(name, n));
+}
+
+// Whether a token continues the word of the token before it
+static int	is_word_part(t_elem *token)
+{
+	return (token && (token->type == WORD || token->type == ENV
+			|| token->type == EXIT_STATUS || token->type == QUOTE
+			|| token->type == DQUOTE || token->type == ESCAPE));
+}
+
+// Cuts the prefix [at, end) out of curr: curr keeps what is before it,
+// then come a quoted token with dir and an unquoted one with the rest.
+// Returns the latter, or NULL when out of memory.
+static t_elem	*split_prefix(t_elem *curr, int at, int end, const char *dir)
+{
+	t_elem	*home;
+	t_elem	*rest;
+	char	*before;
+
+	home = create_token((char *)dir, WORD, IN_QUOTE);
+	rest = create_token(curr->content + end, WORD, GENERAL);
+	before = ft_strndup(curr->content, at);
+	if (!home || !rest || !before)
+	{
+		free_token_list(home);
+		free_token_list(rest);
+		free(before);
+		return (NULL);
+	}
+	free(curr->content);
+	curr->content = before;
+	rest->next = curr->next;
+	home->next = rest;
+	curr->next = home;
+	return (rest);
+}
+
+// Expands the tilde prefixes of one unquoted token that starts a word;
+// in an assignment they follow the '=' or a ':'
+static int	tilde_token(t_elem *curr, t_env *env_list)
+{
+	const char	*dir;
+	int			assign;
+	int			at;
+	int			end;
+
+	at = 0;
+	while (is_valid_var_char(curr->content[at]))
+		at++;
+	assign = (at > 0 && curr->content[at] == '='
+			&& !ft_isdigit(curr->content[0]));
+	at = (at + 1) * assign;
+	while (1)
+	{
+		dir = NULL;
+		end = at + 1;
+		while (curr->content[at] == '~' && curr->content[end]
+			&& curr->content[end] != '/'
+			&& !(assign && curr->content[end] == ':'))
+			end++;
+		if (curr->content[at] == '~'
+			&& (curr->content[end] || !is_word_part(curr->next)))
+			dir = tilde_dir(curr->content + at + 1, end - at - 1, env_list);
+		if (dir)
+			curr = split_prefix(curr, at, end, dir);
+		if (!curr)
+			return (0);
+		at *= !dir;
+		while (assign && curr->content[at] && curr->content[at] != ':')
+			at++;
+		if (!assign || !curr->content[at])
+			return (1);
+		at++;
+	}
+}
+
+// Runs tilde expansion over a command's tokens. Returns 0 when out of
+// memory.
+int	expand_tildes(t_elem *token, t_env *env_list)
+{
+	t_elem	*prev;
+
+	prev = NULL;
+	while (token)
+	{
+		if (token->type == WORD && token->state == GENERAL
+			&& !is_word_part(prev) && !tilde_token(token, env_list))
+			return (0);
+		prev = token;
+		token = token->next;
+	}
+	return (1);
+}
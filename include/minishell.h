@@ -17,9 +17,52 @@
 # include <fcntl.h>
 # include <sys/wait.h>
 # include <errno.h>
+# include <poll.h>
+# include <sys/select.h>
+# include <sys/stat.h>
+# include <limits.h>
+# include <stdint.h>
+# include <fnmatch.h>
+# include <regex.h>
+# include <time.h>
+# include <sys/resource.h>
+# include <pthread.h>
+# include <sched.h>
 # include "../libft/libft.h"
 # include "get_next_line.h"
 
+/* Number of parsed input lines kept by the parse cache */
+# define PARSE_CACHE_SIZE 64
+
+/* Hash bits used per level of the environment trie */
+# define ENV_TRIE_BITS 5
+
+/* Levels of the sorted index of variable names */
+# define ENV_INDEX_LEVELS 16
+
+/* Buckets of the command path cache */
+# define PATH_CACHE_SIZE 64
+
+/* Buckets of the ~user cache, and how long (seconds) an answer is kept */
+# define TILDE_CACHE_SIZE 32
+# define TILDE_CACHE_TTL 300
+
+/* log2 buckets of the shellstats latency histograms */
+# define STATS_BUCKETS 32
+
+/* Descriptors the shell keeps for itself start here, clear of "exec 3>x" */
+# define SHELL_FD_BASE 10
+
+/* Read size for directory listings during pathname expansion */
+# define GLOB_DENTS_BUF 65536
+
+/* Upper bound on GLOBSTAR_THREADS, the threads that walk a "**" */
+# define GLOB_MAX_THREADS 64
+
+/* Kinds of IFS characters */
+# define IFS_SPACE 1
+# define IFS_OTHER 2
+
 /* ========================================================================== */
 /*                               ENUMS                                        */
 /* ========================================================================== */
@@ -40,7 +83,38 @@ enum e_type
 	NEW_LINE = '\n',
 	EXIT_STATUS,
 	HERE_DOC,
+	AND_IF,
+	OR_IF,
 	ESCAPE = '\\',
+	BACKGROUND = '&',
+	SEMICOLON = ';',
+	LPAREN = '(',
+	RPAREN = ')',
+	DUP_IN,
+	DUP_OUT,
+};
+
+enum e_list_op
+{
+	OP_END,
+	OP_SEQ,
+	OP_AND,
+	OP_OR,
+	OP_BACKGROUND
+};
+
+enum e_time_mode
+{
+	TIME_NONE,
+	TIME_DEFAULT,
+	TIME_POSIX,
+	TIME_VERBOSE
+};
+
+enum e_job_state
+{
+	JOB_RUNNING,
+	JOB_DONE
 };
 
 enum e_state
@@ -56,13 +130,58 @@ enum e_state
 
 // UPDATED: Added env_list field to support environment passing
 
-typedef struct s_env
+// A variable of the environment trie (see env_trie.c); shared between
+// versions, so never changed once it is in one. seq orders the variables
+// by when their name was first set.
+typedef struct s_envvar
 {
 	char			*name;
 	char			*value;
-	struct s_env	*next;
+	unsigned long	hash;
+	unsigned long	seq;
+	int				refs;
+}					t_envvar;
+
+// map: the slots in use, leaf: those of them that hold a t_envvar rather
+// than a node one level down; slot has one entry per bit of map
+typedef struct s_envnode
+{
+	unsigned int	map;
+	unsigned int	leaf;
+	int				refs;
+	void			*slot[];
+}					t_envnode;
+
+// A name in the sorted index (see env_index.c), with one link per level
+typedef struct s_envkey
+{
+	char			*name;
+	struct s_envkey	*next[];
+}					t_envkey;
+
+// The shell's variables: the current version of the trie. bytes is what
+// execve() needs for those with a value; index has their names in order;
+// seq is the last t_envvar.seq given out; order has the variables of the
+// version order_root in seq order, kept until the table changes.
+typedef struct s_env
+{
+	t_envnode		*root;
+	t_envkey		*index;
+	int				count;
+	size_t			bytes;
+	unsigned long	seq;
+	t_envnode		*order_root;
+	t_envvar		**order;
 }					t_env;
 
+// Byte ranges of an expansion result that came from $ expansions
+typedef struct s_spans
+{
+	int	*at;
+	int	count;
+	int	cap;
+}		t_spans;
+
 typedef struct s_expand_data
 {
 	char		**res;
@@ -70,27 +189,183 @@ typedef struct s_expand_data
 	int			*max;
 	int			exit_code;
 	t_env		*env_list;  // ADDED: Environment list for expansion
+	struct s_spans	*spans;
+	struct s_spans	*fields;
 }				t_expand_data;
 
+// One ${...} expansion: its text, the parameter and its value (NULL when
+// unset), and for ${x/p/r} which of / // /# /% it is
+typedef struct s_param
+{
+	const char		*body;
+	char			*name;
+	char			*value;
+	char			mode;
+	t_expand_data	*data;
+}					t_param;
+
 // REMOVED: Global environment variable declaration
 // extern t_env	*g_envp;
 
+// A redirection of fd other than a stdin/stdout file: fd becomes a copy of
+// src when the command starts (src -1 closes it). saved holds the previous
+// fd while a builtin runs.
+typedef struct s_redir
+{
+	int				fd;
+	int				src;
+	int				owned;
+	int				saved;
+	struct s_redir	*next;
+}					t_redir;
+
 typedef struct s_cmd
 {
 	int				in_file;
 	int				out_file;
+	t_redir			*redirs;
 	char			**full_cmd;
+	char			**assigns;
+	pid_t			pid;
 	struct s_cmd	*next;
 }					t_cmd;
 
+// split: for an expanded unquoted token, the byte ranges that came from
+// expansions as start, end pairs ending in -1 (NULL if there were none).
+// fields: for a double-quoted token where "$@" gave several parameters,
+// the offsets of the spaces between them, each of which ends a field,
+// ending in -1 (NULL if there were none)
 typedef struct s_elem
 {
 	char			*content;
 	enum e_type		type;
 	enum e_state	state;
+	int				*split;
+	int				*fields;
 	struct s_elem	*next;
 }					t_elem;
 
+enum e_node_kind
+{
+	NODE_PIPELINE,
+	NODE_IF,
+	NODE_WHILE,
+	NODE_UNTIL,
+	NODE_FOR,
+	NODE_GROUP,
+	NODE_FUNCDEF
+};
+
+// One command of a command list, with the operator that ended it. A
+// pipeline keeps its tokens; if/while/until/for keep their parts as nested
+// lists (for uses tokens for the words after "in"). A function definition
+// keeps its name in var and its compound body in body. timed is set by a
+// leading "time".
+typedef struct s_node
+{
+	enum e_node_kind	kind;
+	enum e_time_mode	timed;
+	t_elem				*tokens;
+	char				*var;
+	int					has_in;
+	struct s_node		*cond;
+	struct s_node		*body;
+	struct s_node		*alt;
+	enum e_list_op		op;
+	struct s_node		*next;
+}						t_node;
+
+// A function body, shared by its definition and the calls running it;
+// freed once none of them holds it any more
+typedef struct s_fbody
+{
+	t_node	*list;
+	int		refs;
+}			t_fbody;
+
+typedef struct s_func
+{
+	char			*name;
+	t_fbody			*body;
+	struct s_func	*next;
+}					t_func;
+
+// Positional parameters of a function call; args[0] is $0
+typedef struct s_frame
+{
+	char			**args;
+	int				count;
+	int				*status;
+	struct s_frame	*prev;
+}					t_frame;
+
+// State of one $(( )) evaluation
+typedef struct s_arith
+{
+	const char	*expr;
+	const char	*s;
+	int			pos;
+	t_env		*env_list;
+	int			error;
+	int			skip;
+	int			depth;
+}				t_arith;
+
+// State of one test / [ / [[ evaluation
+typedef struct s_test
+{
+	char	*name;
+	char	**args;
+	int		count;
+	int		pos;
+	int		extended;
+	int		error;
+}			t_test;
+
+typedef struct s_lparser
+{
+	t_elem	*cur;
+	int		error;
+}			t_lparser;
+
+// Parse cache entry: one raw input line and the list it parsed to
+typedef struct s_pentry
+{
+	char				*input;
+	unsigned long		hash;
+	t_node				*list;
+	int					pins;
+	struct s_pentry		*prev;
+	struct s_pentry		*next;
+}						t_pentry;
+
+typedef struct s_pcache
+{
+	t_pentry		*head;
+	t_pentry		*tail;
+	int				count;
+	unsigned long	hits;
+	unsigned long	misses;
+}					t_pcache;
+
+typedef struct s_job
+{
+	int					id;
+	pid_t				pid;
+	int					status;
+	enum e_job_state	state;
+	char				*cmd;
+	struct s_job		*next;
+}						t_job;
+
+// A running <( ) or >( ) and the shell's end of its pipe
+typedef struct s_psub
+{
+	pid_t			pid;
+	int				fd;
+	struct s_psub	*next;
+}					t_psub;
+
 typedef struct s_lexer
 {
 	char	*input;
@@ -125,6 +400,257 @@ typedef struct s_exec
 	t_exprt		*export;
 }				t_exec;
 
+enum e_pjob_state
+{
+	PJOB_PENDING,
+	PJOB_RUNNING,
+	PJOB_DONE,
+	PJOB_FLUSHED
+};
+
+typedef struct s_pjob
+{
+	char				*line;
+	pid_t				pid;
+	int					fd;
+	char				*out;
+	size_t				len;
+	size_t				cap;
+	int					status;
+	enum e_pjob_state	state;
+}						t_pjob;
+
+typedef struct s_parallel
+{
+	t_pjob		*jobs;
+	int			count;
+	int			slots;
+	int			keep_order;
+	int			next_start;
+	int			next_flush;
+	int			running;
+	int			failed;
+}				t_parallel;
+
+typedef struct s_pathent
+{
+	char				*name;
+	char				*path;
+	struct s_pathent	*next;
+}						t_pathent;
+
+typedef struct s_tildent
+{
+	char				*name;
+	char				*dir;
+	long				stamp;
+	struct s_tildent	*next;
+}						t_tildent;
+
+enum e_stat
+{
+	STAT_LINES,
+	STAT_LINES_PARSED,
+	STAT_COMMANDS,
+	STAT_FORKS,
+	STAT_EXECS,
+	STAT_PATH_LOOKUPS,
+	STAT_PATH_HITS,
+	STAT_ENV_REBUILDS,
+	STAT_TILDE_LOOKUPS,
+	STAT_TILDE_HITS,
+	STAT_COUNT
+};
+
+enum e_hist
+{
+	HIST_SPAWN,
+	HIST_PARSE,
+	HIST_COUNT
+};
+
+typedef struct s_stats
+{
+	unsigned long	count[STAT_COUNT];
+	unsigned long	hist[HIST_COUNT][STATS_BUCKETS];
+}					t_stats;
+
+enum e_pat_op
+{
+	PAT_LIT,
+	PAT_ANY,
+	PAT_STAR,
+	PAT_SET
+};
+
+// One step of a compiled pattern: a literal run, ?, *, or a [...] set
+typedef struct s_patop
+{
+	enum e_pat_op	op;
+	const char		*lit;
+	size_t			len;
+	unsigned char	set[32];
+}					t_patop;
+
+typedef struct s_pattern
+{
+	t_patop	*ops;
+	int		count;
+	char	*text;
+	size_t	min_len;
+	int		magic;
+	int		stars;
+}			t_pattern;
+
+// Record returned by getdents64(2)
+typedef struct s_kdirent
+{
+	unsigned long	d_ino;
+	long			d_off;
+	unsigned short	d_reclen;
+	unsigned char	d_type;
+	char			d_name[];
+}					t_kdirent;
+
+// A directory entry; key is scratch space for sorting
+typedef struct s_dentry
+{
+	unsigned long	key;
+	char			*name;
+	size_t			len;
+	unsigned char	type;
+}					t_dentry;
+
+// Sorted listing of one directory, kept while a command line is expanded
+typedef struct s_dirlist
+{
+	char				*path;
+	t_dentry			*ents;
+	int					count;
+	int					uses;
+	int					sorted;
+	char				*pool;
+	struct s_dirlist	*next;
+}						t_dirlist;
+
+// Growable NULL-terminated argument vector
+typedef struct s_argv
+{
+	char	**v;
+	int		count;
+	int		cap;
+	size_t	bytes;
+}			t_argv;
+
+enum e_brace
+{
+	BRACE_NONE,
+	BRACE_LIST,
+	BRACE_SEQ
+};
+
+// "{from..to..step}", or "{a..z}" when chars is set
+typedef struct s_seq
+{
+	long	from;
+	long	to;
+	long	step;
+	int		width;
+	int		pad;
+	int		chars;
+}			t_seq;
+
+// IFS as a table: IFS_SPACE for IFS whitespace, IFS_OTHER for the other
+// characters. plain is set for the default " \t\n", none for an empty IFS.
+typedef struct s_ifs
+{
+	unsigned char	kind[256];
+	int				plain;
+	int				none;
+}					t_ifs;
+
+// A word being cut into fields: the field being built (text, and the
+// pattern copy with its quoted parts escaped, each with its length and
+// the size of its buffer), whether it has started, whether IFS whitespace
+// has just ended one, and where the fields go
+typedef struct s_word
+{
+	struct s_data	*data;
+	t_argv			*args;
+	size_t			limit;
+	int				literal;
+	char			*text;
+	size_t			text_len;
+	size_t			text_cap;
+	char			*pattern;
+	size_t			pat_len;
+	size_t			pat_cap;
+	int				magic;
+	int				started;
+	int				pending;
+	int				has_ifs;
+	t_ifs			ifs;
+}					t_word;
+
+// State of one brace expansion: where the words go, the budget they must
+// fit in (0 for none) and the word being built
+typedef struct s_brace
+{
+	t_argv	*args;
+	t_env	*env;
+	size_t	limit;
+	char	*buf;
+	size_t	cap;
+}			t_brace;
+
+// State of one pathname expansion: the names found so far and the path
+// being built
+typedef struct s_glob
+{
+	t_argv	out;
+	t_env	*env;
+	char	path[PATH_MAX];
+}			t_glob;
+
+// Queue of one "**" walker thread: directories relative to the root
+typedef struct s_wqueue
+{
+	pthread_mutex_t	lock;
+	char			**items;
+	int				head;
+	int				tail;
+	int				cap;
+}					t_wqueue;
+
+typedef struct s_walker
+{
+	int			root_fd;
+	const char	*base;
+	int			nthreads;
+	long		pending;
+	t_wqueue	*queues;
+}				t_walker;
+
+typedef struct s_wthread
+{
+	t_walker	*walker;
+	int			id;
+	pthread_t	tid;
+	int			started;
+	t_dirlist	*found;
+	int			count;
+}				t_wthread;
+
+typedef struct s_bench
+{
+	char	*line;
+	int		runs;
+	int		warmup;
+	int		json;
+	long	*wall;
+	long	*cpu;
+}			t_bench;
+
 typedef struct s_data
 {
 	t_cmd			*head;
@@ -140,6 +666,8 @@ typedef struct s_data
 	char			*expnd;
 	t_list			*save_error;
 	struct s_env	*n_env;
+	int				tail;
+	int				words_only;
 }			t_data;
 
 /* ========================================================================== */
@@ -162,6 +690,7 @@ int			check_empty_line(t_data *data);
 
 /* Token creation and manipulation */
 t_elem		*create_token(char *content, enum e_type type, enum e_state state);
+t_elem		*copy_token_list(t_elem *src);
 void		append_token(t_elem **head, t_elem *new);
 t_elem		*find_last_token(t_elem *head);
 void		insert_token_after(t_elem *target, t_elem *new_token);
@@ -172,6 +701,8 @@ int			create_content_token(const char *input, int start, int end,
 /* Token processing */
 int			process_single_char_token(t_lexer *lexer, t_elem **head,
 				char c, enum e_type type);
+int			process_operator_token(t_lexer *lexer, t_elem **head,
+				int len, enum e_type type);
 int			process_special_chars(t_lexer *lexer, t_elem **head);
 int			process_escape_token(t_lexer *lexer, t_elem **head);
 int			process_exit_status(t_lexer *lexer, t_elem **head);
@@ -231,13 +762,22 @@ int			handle_redirection_out(t_data *data, t_elem **current, t_cmd *cmd);
 int			handle_redirection_append(t_data *data, t_elem
 				**current, t_cmd *cmd);
 int			handle_heredoc(t_data *data, t_elem **current, t_cmd *cmd);
+int			handle_redirection_dup(t_data *data, t_elem **current,
+				t_cmd *cmd);
 int			process_redirection(t_data *data, t_elem **current, t_cmd *cmd);
 
+/* Command lists */
+t_node		*parse_list(t_elem **tokens, int *error);
+void		free_node_list(t_node *list);
+t_node		*copy_node_list(t_node *list);
+t_node		*parse_cache_get(const char *input);
+int			parse_cache_put(const char *input, t_node *list);
+void		parse_cache_release(t_node *list);
+t_node		*parse_cache_lookup(char *input, int *cached, int *error);
+
 /* Parser utilities */
 void		skip_whitespace_ptr(t_elem **current);
-int			count_command_args(t_elem *start);
 int			is_redirection_target(t_elem *elem, t_elem *start);
-int			allocate_cmd_args(t_cmd *cmd, int arg_count);
 int			process_word_token(t_data *data, t_elem **current, t_cmd *cmd, int *arg_index);
 
 /* ========================================================================== */
@@ -245,7 +785,43 @@ int			process_word_token(t_data *data, t_elem **current, t_cmd *cmd, int *arg_in
 /* ========================================================================== */
 
 /* Main expansion functions - UPDATED: All now take env_list parameter */
-void		expand_tokens(t_elem *token, int exit_code, t_env *env_list);
+int			expand_tokens(t_elem *token, int exit_code, t_env *env_list);
+int			expand_tildes(t_elem *token, t_env *env_list);
+int			eval_arith(const char *expr, t_env *env_list, long long *result);
+char		*arith_itoa(long long value);
+int			process_arith_expansion(char *content, int *i,
+				t_expand_data *data);
+int			skip_dollar_paren(const char *input, int i);
+int			skip_dollar_brace(const char *input, int i);
+int			process_param_expansion(char *content, int *i,
+				t_expand_data *data);
+int			process_command_subst(char *content, int *i,
+				t_expand_data *data);
+char		*command_substitution(char *text, int exit_code,
+				t_env *env_list);
+void		subst_status_reset(void);
+int			subst_status(void);
+int			pattern_compile(t_pattern *pat, const char *src);
+int			pattern_match(const t_pattern *pat, const char *s, size_t n);
+void		pattern_free(t_pattern *pat);
+int			pattern_is_magic(const char *s);
+int			argv_push(t_argv *av, char *s);
+int			argv_push_all(t_argv *av, char **names);
+char		*glob_escape(const char *s);
+char		*glob_unescape(const char *s);
+char		**glob_word(const char *pattern, t_env *env_list);
+int			glob_walk(t_glob *g, size_t plen, const char *rest);
+int			glob_globstar(t_glob *g, size_t plen, const char *rest);
+t_dirlist	*read_dirlist(int fd, const char *path);
+void		free_dirlist(t_dirlist *dir);
+t_dirlist	*glob_cache_find(const char *path);
+t_dirlist	*glob_cache_add(t_dirlist *dir);
+void		sort_dentries(t_dentry *ents, int n);
+void		glob_cache_clear(void);
+int			brace_find(const char *s, size_t *open, size_t *close);
+int			word_add_part(t_word *w, t_elem *part);
+int			word_push(t_word *w);
+int			brace_expand(t_brace *b, const char *word);
 char		*expand_merged_token(char *content, int exit_code);
 char		*expand_token_content(char *content, int exit_code, int should_expand, t_env *env_list);
 char		*expand_exit_status(int exit_code);
@@ -254,12 +830,13 @@ char		*extract_var_name(char *str, int start, int *end);
 /* Quote handling - UPDATED: Now takes env_list parameter */
 char		*remove_quotes(char *content, enum e_type quote_type);
 char		*remove_quotes_from_token(char *content, enum e_state state);
-void		handle_quoted_token(t_elem *curr, int exit_code, t_env *env_list);
-void		handle_word_token(t_elem *curr, int exit_code, t_env *env_list);
+int			handle_quoted_token(t_elem *curr, int exit_code, t_env *env_list);
+int			handle_word_token(t_elem *curr, int exit_code, t_env *env_list);
 
 /* Expansion utilities - UPDATED: get_env_value now takes env_list parameter */
 char		*realloc_result(char *result, int *max_size, int needed);
 char		*get_env_value(t_env *env_list, char *name);
+int			set_env_value(t_env **env_list, char *name, char *value);
 int			copy_var_value(char **res, int *len, int *max, char *val);
 int			handle_dollar(char *content, int *i, char **res, int *len);
 
@@ -269,6 +846,7 @@ int			process_dollar_expansion(char *content, int *i, t_expand_data *data);
 int			process_expansion_loop(char *content, t_expand_data *data);
 int			process_regular_char(char *content, int *i, t_expand_data *data);
 int			is_valid_var_char(char c);
+int			is_valid_identifier(const char *name);
 void		cleanup_var_expansion(char *name, char *value, int is_special);
 void		cleanup_var_expansion_two(char *name, char *value, int is_special);
 
@@ -277,12 +855,27 @@ void		cleanup_var_expansion_two(char *name, char *value, int is_special);
 /* ========================================================================== */
 
 /* Environment list management - UPDATED: init_env_list returns t_env* */
-t_env		*create_env_node(const char *env);
-void		add_env_back(t_env **lst, t_env *new_node);
 t_env		*init_env_list(char **envp);
 void		free_env_list(t_env *env);
+t_envvar	*env_find(t_env *env, const char *name);
+int			env_put(t_env *env, t_envvar *var);
+int			env_set(t_env *env, const char *name, const char *value);
+int			env_unset(t_env *env, const char *name);
+void		env_snapshot(t_env *env, t_env *snap);
+void		env_node_release(t_envnode *node);
+t_envvar	**env_vars(t_env *env);
+void		env_vars_free(t_env *env);
+int			env_index_add(t_env *env, const char *name, unsigned long hash);
+void		env_index_del(t_env *env, const char *name);
+void		env_index_free(t_env *env);
 // UPDATED: builtin_env now takes env_list parameter
-int			builtin_env(t_env *env_list);
+int			builtin_env(char **args, t_env *env_list);
+char		**env_overlay(char **envp, char **sets, char **unsets);
+char		**env_with_assigns(char **envp, char **assigns);
+void		assigns_export(char **assigns, t_env **env_list);
+void		assigns_apply(char **assigns, t_env *env_list, t_env *saved);
+void		assigns_restore(char **assigns, t_env *env_list, t_env *saved);
+int			unset_single_var(char *var_name, t_env **env_list);
 
 /* ========================================================================== */
 /*                          UTILITY FUNCTIONS                                */
@@ -325,6 +918,7 @@ int			ft_strcmp(const char *s1, const char *s2);
 
 /* Main input processing - UPDATED: Now takes env_list parameter */
 int			process_input(char *input, int *last_exit_code, t_env **env_list);
+t_node		*parse_input_line(char *input, int *error);
 
 /* ===================== SIGNALS ===================== */
 void		sigint_wrapper(int signo);
@@ -361,23 +955,92 @@ void		execute_child_command(t_cmd *cmd, char **envp, t_env **env_list);
 int			handle_child_process(t_cmd *cmd, int *pipefd, int prev_fd, char **envp, t_env **env_list);
 char		**init_pipeline(t_data *data, t_env *env_list);
 int			execute_pipeline_commands(t_cmd *cmd, char **envp, t_env **env_list);
-int			wait_and_cleanup(char **envp);
+int			wait_and_cleanup(t_cmd *cmd, char **envp);
 int			execute_one_pipeline_step(t_cmd *cmd, char **envp, int *prev_fd, int pipefd[2], t_env **env_list);
 
+/* COMMAND LISTS AND JOBS */
+int			execute_list(t_node *list, int *last_exit_code, t_env **env_list);
+int			run_pipeline_node(t_elem *tokens, int tail, int *last_exit_code,
+				t_env **env_list);
+void		set_tail_exec(int enabled);
+void		set_interactive(int enabled);
+void		fatal_error(void);
+int			shell_failed(void);
+int			run_command_node(t_node *node, int tail, int *last_exit_code,
+				t_env **env_list);
+int			time_command(t_node *node, int *last_exit_code,
+				t_env **env_list);
+pid_t		wait_child(pid_t pid, int *status);
+long		shell_cpu_usec(void);
+long		now_usec(void);
+void		stats_count(enum e_stat which, unsigned long n);
+void		stats_latency(enum e_hist which, long usec);
+pid_t		shell_fork(void);
+void		stats_exec(void);
+void		path_cache_clear(void);
+char		*path_cache_find(const char *name, const char *path_value,
+				int verify);
+void		path_cache_add(const char *name, const char *path_value,
+				const char *path);
+void		path_cache_prime(char *cmd, t_env *env_list);
+int			run_and_or(t_node *node, t_node *end, int *last_exit_code,
+				t_env **env_list);
+int			launch_background_job(t_node *first, t_node *last,
+				int *last_exit_code, t_env **env_list);
+t_node		*find_function(const char *name);
+int			define_function(const char *name, t_node *body);
+int			call_function(t_node *body, char **args, t_env **env_list);
+int			run_function_command(t_cmd *cmd, t_node *body,
+				t_env **env_list);
+int			function_returning(void);
+void		set_caller_status(int status);
+void		set_positional_params(char **args);
+t_frame		*current_frame(void);
+char		*positional_value(const char *name, t_env *env_list);
+char		*process_substitution(char dir, char *text, int exit_code,
+				t_env *env_list);
+int			proc_subst_mark(void);
+void		reap_proc_substs(int mark);
+int			init_job_control(void);
+int			job_event_fd(void);
+int			reap_jobs(void);
+void		report_jobs(void);
+
 /* SINGLE_COMMAND_UTILS - UPDATED: Functions now take env_list parameters */
 int			execute_single_command(t_cmd *cmd, t_env **env_list);
 int			execute_builtin_command(t_cmd *cmd, t_env **env_list);
 void		setup_and_exec_child(t_cmd *cmd, char **envp, t_env *env_list);
 int			fork_and_execute(t_cmd *cmd, char **envp, t_env *env_list);
+int			exec_in_place(t_cmd *cmd, t_env **env_list);
+
+/* FD_REDIRS */
+int			move_fd_high(int fd);
+int			set_cmd_fd(t_cmd *cmd, int io, int src, int owned);
+int			dup_cmd_fd(t_cmd *cmd, int m, int *owned);
+void		free_redirs(t_redir *redir);
+void		apply_fd_redirs(t_cmd *cmd);
+void		save_fd_redirs(t_cmd *cmd);
+void		restore_fd_redirs(t_cmd *cmd);
 
 /* ===================== BUILTINS ===================== */
 // UPDATED: All builtins now take env_list parameters where needed
-int			builtin_cd(char **args, t_env *env_list);
+int			builtin_cd(char **args, t_env **env_list);
 int			builtin_echo(char **args);
-int			builtin_pwd(void);
+int			builtin_pwd(char **args);
+void		pwd_init(t_env **env_list);
 int			builtin_export(char **args, t_env **env_list);
 int			builtin_unset(char **args, t_env **env_list);
 int			builtin_exit(char **args, t_env *env_list);
+int			builtin_parallel(char **args, t_env **env_list);
+int			builtin_jobs(char **args);
+int			builtin_wait(char **args);
+int			builtin_parsecache(char **args);
+int			builtin_return(char **args);
+int			builtin_test(char **args);
+int			builtin_exec(t_cmd *cmd, t_env **env_list, int in_shell);
+int			builtin_times(void);
+int			builtin_bench(char **args, t_env **env_list);
+int			builtin_shellstats(char **args);
 
 /* ===================== CLEANUP ===================== */
 void		free_cmd_list(t_cmd *head);
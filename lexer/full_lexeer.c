@@ -14,6 +14,7 @@ void	init_data(t_data *data, char *input)
 	data->expnd = NULL;
 	data->save_error = NULL;
 	data->n_env = NULL;
+	data->words_only = 0;
 }
 
 t_lexer	*init_lexer(char *input)
@@ -29,6 +30,21 @@ t_lexer	*init_lexer(char *input)
 	return (lexer);
 }
 
+// A redirection operator here, maybe after an fd number ("2>&1"); "<(" and
+// ">(" start a process substitution instead
+static int	redirection_at(const char *input, int i)
+{
+	int	start;
+
+	start = i;
+	while (ft_isdigit(input[i]))
+		i++;
+	if ((input[i] != '<' && input[i] != '>') || input[i + 1] == '(')
+		return (0);
+	return (i == start || start == 0
+		|| ft_strchr(" \t|&;()<>", input[start - 1]) != NULL);
+}
+
 t_elem	*init_tokens(t_lexer *lexer)
 {
 	t_elem	*head;
@@ -42,7 +58,7 @@ t_elem	*init_tokens(t_lexer *lexer)
 			lexer->position = handle_space(lexer->input, &(lexer->position), &head);
 		else if (current == '\'' || current == '\"')
 			handle_quote(lexer->input, &(lexer->position), &head);
-		else if (current == '>' || current == '<')
+		else if (redirection_at(lexer->input, lexer->position))
 			lexer->position = handle_redirections(lexer->input, lexer->position, &head);
 		else if (process_special_chars(lexer, &head))
 			continue ;
@@ -91,10 +107,40 @@ t_elem	*create_token(char *content, enum e_type type, enum e_state state)
 	}
 	token->type = type;
 	token->state = state;
+	token->split = NULL;
+	token->fields = NULL;
 	token->next = NULL;
 	return (token);
 }
 
+// Deep copy of a token list; expansion rewrites tokens in place, so anything
+// that runs the same tokens more than once works on a copy
+t_elem	*copy_token_list(t_elem *src)
+{
+	t_elem	*head;
+	t_elem	*tail;
+	t_elem	*token;
+
+	head = NULL;
+	tail = NULL;
+	while (src)
+	{
+		token = create_token(src->content, src->type, src->state);
+		if (!token)
+		{
+			free_token_list(head);
+			return (NULL);
+		}
+		if (!head)
+			head = token;
+		else
+			tail->next = token;
+		tail = token;
+		src = src->next;
+	}
+	return (head);
+}
+
 int	process_single_char_token(t_lexer *lexer, t_elem **head, char c, enum e_type type)
 {
 	char	*content;
@@ -124,13 +170,20 @@ int	process_special_chars(t_lexer *lexer, t_elem **head)
 	// 	lexer->position = handle_env(lexer->input, &(lexer->position), head);
 	// 	return (lexer->position != -1);
 	// }
+	else if (current == '|' && lexer->input[lexer->position + 1] == '|')
+		return (process_operator_token(lexer, head, 2, OR_IF));
+	else if (current == '&' && lexer->input[lexer->position + 1] == '&')
+		return (process_operator_token(lexer, head, 2, AND_IF));
 	else if (current == '|')
-	{
-		if (!process_single_char_token(lexer, head, current, PIPE_LINE))
-			return (0);
-		lexer->position++;
-		return (1);
-	}
+		return (process_operator_token(lexer, head, 1, PIPE_LINE));
+	else if (current == '&')
+		return (process_operator_token(lexer, head, 1, BACKGROUND));
+	else if (current == ';')
+		return (process_operator_token(lexer, head, 1, SEMICOLON));
+	else if (current == '(')
+		return (process_operator_token(lexer, head, 1, LPAREN));
+	else if (current == ')')
+		return (process_operator_token(lexer, head, 1, RPAREN));
 	else if (current == '\\')
 		return (process_escape_token(lexer, head));
 	else if (current == '\n')
@@ -143,6 +196,25 @@ int	process_special_chars(t_lexer *lexer, t_elem **head)
 	return (0);
 }
 
+// Emits a control operator token ("|", "||", "&&", "&", ";", "(", ")")
+int	process_operator_token(t_lexer *lexer, t_elem **head, int len,
+		enum e_type type)
+{
+	char	*content;
+	t_elem	*token;
+
+	content = ft_strndup(&lexer->input[lexer->position], len);
+	if (!content)
+		return (0);
+	token = create_token(content, type, GENERAL);
+	free(content);
+	if (!token)
+		return (0);
+	append_token(head, token);
+	lexer->position += len;
+	return (1);
+}
+
 int	process_exit_status(t_lexer *lexer, t_elem **head)
 {
 	char	*content;
@@ -189,7 +261,14 @@ void	handle_quote(const char *input, int *i, t_elem **head)
 	state = (quote == '\'') ? IN_QUOTE : IN_DQUOTE;
 	start = *i;
 	while (input[*i] && input[*i] != quote)
-		(*i)++;
+	{
+		if (quote == '\"' && input[*i] == '$' && input[*i + 1] == '(')
+			*i = skip_dollar_paren(input, *i);
+		else if (quote == '\"' && input[*i] == '$' && input[*i + 1] == '{')
+			*i = skip_dollar_brace(input, *i);
+		else
+			(*i)++;
+	}
 	if (*i == start)
 	{
 		if (input[*i] == quote)
@@ -210,11 +289,20 @@ int	handle_redirections(const char *input, int i, t_elem **head)
 	t_elem		*token;
 
 	start = i;
+	while (ft_isdigit(input[i]))
+		i++;
 	if (input[i] == '>' && input[i + 1] && input[i + 1] == '>')
 	{
 		type = DREDIR_OUT;
 		i += 2;
 	}
+	else if ((input[i] == '>' || input[i] == '<') && input[i + 1] == '&')
+	{
+		type = DUP_IN;
+		if (input[i] == '>')
+			type = DUP_OUT;
+		i += 2;
+	}
 	else if (input[i] == '<' && input[i + 1] && input[i + 1] == '<')
 	{
 		type = HERE_DOC;
@@ -323,6 +411,62 @@ int	handle_space(const char *input, int *i, t_elem **head)
 	append_token(head, token);
 	return (*i);
 }
+// i is on the '$' of "$(" or "$((" (or the '<' / '>' of a process
+// substitution); returns the index just past the ')'
+// that closes it (or the end of input), skipping nested parens and quotes
+int	skip_dollar_paren(const char *input, int i)
+{
+	int		depth;
+	char	quote;
+
+	depth = 0;
+	quote = 0;
+	i++;
+	while (input[i])
+	{
+		if (quote && input[i] == quote)
+			quote = 0;
+		else if (!quote && (input[i] == '\'' || input[i] == '"'))
+			quote = input[i];
+		else if (!quote && input[i] == '(')
+			depth++;
+		else if (!quote && input[i] == ')' && --depth == 0)
+			return (i + 1);
+		i++;
+	}
+	return (i);
+}
+
+// i is on the '$' of "${"; returns the index just past the '}' that
+// closes it (or the end of input), skipping nested braces, quotes,
+// backslashed characters and $( )
+int	skip_dollar_brace(const char *input, int i)
+{
+	int		depth;
+	char	quote;
+
+	depth = 0;
+	quote = 0;
+	i++;
+	while (input[i])
+	{
+		if (quote && input[i] == quote)
+			quote = 0;
+		else if (quote != '\'' && input[i] == '\\' && input[i + 1])
+			i++;
+		else if (!quote && (input[i] == '\'' || input[i] == '"'))
+			quote = input[i];
+		else if (quote != '\'' && input[i] == '$' && input[i + 1] == '(')
+			i = skip_dollar_paren(input, i) - 1;
+		else if (!quote && input[i] == '{')
+			depth++;
+		else if (!quote && input[i] == '}' && --depth == 0)
+			return (i + 1);
+		i++;
+	}
+	return (i);
+}
+
 int	handle_word(const char *input, int i, t_elem **head)
 {
 	int		start;
@@ -330,10 +474,21 @@ int	handle_word(const char *input, int i, t_elem **head)
 	t_elem	*token;
 
 	start = i;
+	if ((input[i] == '<' || input[i] == '>') && input[i + 1] == '(')
+		i = skip_dollar_paren(input, i);
 	while (input[i] && input[i] != ' ' && input[i] != '\t' &&
 		input[i] != '|' && input[i] != '<' && input[i] != '>' &&
+		input[i] != '&' && input[i] != ';' && input[i] != '\n' &&
+		input[i] != '(' && input[i] != ')' &&
 		input[i] != '\'' && input[i] != '\"')
-		i++;
+	{
+		if (input[i] == '$' && input[i + 1] == '(')
+			i = skip_dollar_paren(input, i);
+		else if (input[i] == '$' && input[i + 1] == '{')
+			i = skip_dollar_brace(input, i);
+		else
+			i++;
+	}
 	if (i > start)
 	{
 		content = ft_strndup(input + start, i - start);
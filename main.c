@@ -12,54 +12,132 @@
 
 #include "minishell.h"
 
-// Updated to take env_list parameter
-int process_input(char *input, int *last_exit_code, t_env **env_list)
+// Lexes the line and splits it into a command list
+t_node *parse_input_line(char *input, int *error)
 {
-    t_data data = {0};
-    t_lexer *lexer = NULL;
+    t_lexer *lexer;
+    t_elem *tokens;
+    t_node *list;
+    long start;
 
-    if (!input || !*input)
-        return (1);
-    
+    *error = 0;
+    start = now_usec();
     lexer = init_lexer(input);
     if (!lexer)
-        return (0);
+        return (NULL);
     
-    data.elem = init_tokens(lexer);
-    if (!data.elem)
-    {
-        free(lexer);
-        return (0);
-    }
+    tokens = init_tokens(lexer);
+    free_lexer(lexer);
+    if (!tokens)
+        return (NULL);
     
-    merge_adjacent_word_tokens(&data.elem);
-    // Updated: Pass env_list to expand_tokens
-    expand_tokens(data.elem, *last_exit_code, *env_list);
+    merge_adjacent_word_tokens(&tokens);
+    list = parse_list(&tokens, error);
+    stats_count(STAT_LINES_PARSED, 1);
+    stats_latency(HIST_PARSE, now_usec() - start);
+    return (list);
+}
+
+// Runs one input line. Repeated lines reuse their parsed list from the
+// parse cache; only expansion and redirections are redone.
+int process_input(char *input, int *last_exit_code, t_env **env_list)
+{
+    t_node *list;
+    int error;
+    int cached;
+
+    if (!input || !*input)
+        return (1);
+    stats_count(STAT_LINES, 1);
     
-    if (!parse_pipeline(&data))
+    list = parse_cache_get(input);
+    cached = (list != NULL);
+    if (!list)
     {
-        cleanup_resources(&data, lexer, NULL);
-        return (0);
+        list = parse_input_line(input, &error);
+        if (!list)
+        {
+            if (error)
+                *last_exit_code = 2;
+            return (!error);
+        }
+        cached = parse_cache_put(input, list);
     }
     
-    // Set the exit status pointer in data for signal handlers
-    data.exit_status = *last_exit_code;
-    
-    // Updated: Pass env_list to execute_pipeline
-    *last_exit_code = execute_pipeline(&data, env_list);
-    cleanup_resources(&data, lexer, NULL);
+    execute_list(list, last_exit_code, env_list);
+    if (cached)
+        parse_cache_release(list);
+    else
+        free_node_list(list);
     return (1);
 }
 
+static char *g_input_line = NULL;
+static int g_input_done = 0;
+
+static void line_handler(char *line)
+{
+    g_input_line = line;
+    g_input_done = 1;
+    rl_callback_handler_remove();
+}
+
+// Waits for a full input line while reaping background jobs as they finish,
+// so the prompt never blocks on children. Returns NULL on EOF.
+static char *read_input(void)
+{
+    fd_set fds;
+    int job_fd;
+
+    report_jobs();
+    g_input_line = NULL;
+    g_input_done = 0;
+    job_fd = job_event_fd();
+    rl_callback_handler_install("minishell$ ", line_handler);
+    while (!g_input_done)
+    {
+        FD_ZERO(&fds);
+        FD_SET(STDIN_FILENO, &fds);
+        if (job_fd != -1)
+            FD_SET(job_fd, &fds);
+        if (select((job_fd > STDIN_FILENO ? job_fd : STDIN_FILENO) + 1,
+                &fds, NULL, NULL, NULL) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            rl_callback_handler_remove();
+            return (NULL);
+        }
+        if (job_fd != -1 && FD_ISSET(job_fd, &fds))
+            reap_jobs();
+        if (FD_ISSET(STDIN_FILENO, &fds))
+            rl_callback_read_char();
+    }
+    return (g_input_line);
+}
+
+// minishell -c 'command string': runs the string and exits with its status.
+// Nothing runs after it, so the last command may replace the shell.
+static int run_command_string(char *input, t_env **env_list)
+{
+    int last_exit_code;
+
+    last_exit_code = 0;
+    init_job_control();
+    set_tail_exec(1);
+    process_input(input, &last_exit_code, env_list);
+    set_tail_exec(0);
+    fflush(stdout);
+    free_env_list(*env_list);
+    return (last_exit_code);
+}
+
 int main(int argc, char **argv, char **envp)
 {
     char *input;
     int last_exit_code = 0;
     t_env *env_list;  // Added: Local environment list
     
-    (void)argc;
-    (void)argv;
-    
     // Updated: Initialize environment and store the returned list
     env_list = init_env_list(envp);
     if (!env_list)
@@ -67,13 +145,22 @@ int main(int argc, char **argv, char **envp)
         fprintf(stderr, "minishell: failed to initialize environment\n");
         return (1);
     }
+    pwd_init(&env_list);
+    if (argc >= 3 && !ft_strcmp(argv[1], "-c"))
+    {
+        // Words after the string become $0, $1, ... like in sh -c
+        set_positional_params(argv + 3);
+        return (run_command_string(argv[2], &env_list));
+    }
     
     // Initialize signal handling
     handle_signals(&last_exit_code);
+    init_job_control();
+    set_interactive(isatty(STDIN_FILENO));
     
-    while (1)
+    while (!shell_failed())
     {
-        input = readline("minishell$ ");
+        input = read_input();
         if (!input)
         {
             printf("exit\n");
@@ -91,4 +178,4 @@ int main(int argc, char **argv, char **envp)
     // Updated: Free the local env_list instead of global g_envp
     free_env_list(env_list);
     return (last_exit_code);
-}
\ No newline at end of file
+}
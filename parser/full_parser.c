@@ -45,12 +45,61 @@ static int	read_heredoc_lines(const char *delimiter, int pipe_fd)
 	return (1);
 }
 
+// The fd number in front of a redirection operator ("2>", "10<&"), def
+// without one, -1 when out of range
+static int	redir_io_number(const char *op, int def)
+{
+	int	n;
+
+	if (!ft_isdigit(*op))
+		return (def);
+	n = 0;
+	while (ft_isdigit(*op))
+	{
+		if (n > (INT_MAX - 9) / 10)
+			return (-1);
+		n = n * 10 + (*op++ - '0');
+	}
+	return (n);
+}
+
+// "M" of "N>&M": -2 unless it is all digits
+static int	fd_word(const char *word)
+{
+	int	i;
+
+	i = 0;
+	while (ft_isdigit(word[i]))
+		i++;
+	if (i == 0 || word[i])
+		return (-2);
+	return (redir_io_number(word, -1));
+}
+
+static int	redir_fd_error(t_data *data, int fd)
+{
+	ft_putstr_fd("minishell: ", 2);
+	if (fd < 0)
+		ft_putstr_fd("file descriptor out of range\n", 2);
+	else
+	{
+		ft_putnbr_fd(fd, 2);
+		ft_putstr_fd(": Bad file descriptor\n", 2);
+	}
+	data->file_error = 1;
+	return (0);
+}
+
 int	handle_heredoc(t_data *data, t_elem **current, t_cmd *cmd)
 {
 	int		pipe_fd[2];
 	char	*delimiter;
+	int		io;
 
 	(void)data;
+	io = redir_io_number((*current)->content, STDIN_FILENO);
+	if (io < 0)
+		return (redir_fd_error(data, io));
 	*current = (*current)->next;
 	skip_whitespace_ptr(current);
 	if (!*current || (*current)->type != WORD)
@@ -64,21 +113,22 @@ int	handle_heredoc(t_data *data, t_elem **current, t_cmd *cmd)
 		return (0);
 	}
 	close(pipe_fd[1]);
-	if (cmd->in_file != STDIN_FILENO)
-		close(cmd->in_file);
-	cmd->in_file = pipe_fd[0];
 	*current = (*current)->next;
-	return (1);
+	return (set_cmd_fd(cmd, io, pipe_fd[0], 1));
 }
 
 
 int handle_redirection_in(t_data *data, t_elem **current, t_cmd *cmd)
 {
     int fd;
+    int io;
 
     if (!data || !current || !*current || !cmd)
         return (0);
 
+    io = redir_io_number((*current)->content, STDIN_FILENO);
+    if (io < 0)
+        return (redir_fd_error(data, io));
     *current = (*current)->next;
     skip_whitespace_ptr(current);
 
@@ -94,22 +144,22 @@ int handle_redirection_in(t_data *data, t_elem **current, t_cmd *cmd)
         return (0);
     }
 
-    if (cmd->in_file != STDIN_FILENO)
-        close(cmd->in_file);
-    cmd->in_file = fd;
-
     *current = (*current)->next;
-    return (1);
+    return (set_cmd_fd(cmd, io, fd, 1));
 }
 
 // Handles '>' redirection (truncate output)
 int handle_redirection_out(t_data *data, t_elem **current, t_cmd *cmd)
 {
     int fd;
+    int io;
 
     if (!data || !current || !*current || !cmd)
         return (0);
 
+    io = redir_io_number((*current)->content, STDOUT_FILENO);
+    if (io < 0)
+        return (redir_fd_error(data, io));
     *current = (*current)->next;
     skip_whitespace_ptr(current);
 
@@ -125,22 +175,22 @@ int handle_redirection_out(t_data *data, t_elem **current, t_cmd *cmd)
         return (0);
     }
 
-    if (cmd->out_file != STDOUT_FILENO)
-        close(cmd->out_file);
-    cmd->out_file = fd;
-
     *current = (*current)->next;
-    return (1);
+    return (set_cmd_fd(cmd, io, fd, 1));
 }
 
 // Handles '>>' redirection (append to output)
 int handle_redirection_append(t_data *data, t_elem **current, t_cmd *cmd)
 {
     int fd;
+    int io;
 
     if (!data || !current || !*current || !cmd)
         return (0);
 
+    io = redir_io_number((*current)->content, STDOUT_FILENO);
+    if (io < 0)
+        return (redir_fd_error(data, io));
     *current = (*current)->next;
     skip_whitespace_ptr(current);
 
@@ -156,12 +206,51 @@ int handle_redirection_append(t_data *data, t_elem **current, t_cmd *cmd)
         return (0);
     }
 
-    if (cmd->out_file != STDOUT_FILENO)
-        close(cmd->out_file);
-    cmd->out_file = fd;
+    *current = (*current)->next;
+    return (set_cmd_fd(cmd, io, fd, 1));
+}
+
+// Handles "N>&M" / "N<&M" (N becomes a copy of M) and "N>&-" (closes N)
+int handle_redirection_dup(t_data *data, t_elem **current, t_cmd *cmd)
+{
+    int io;
+    int m;
+    int src;
+    int owned;
+
+    if (!data || !current || !*current || !cmd)
+        return (0);
 
+    io = redir_io_number((*current)->content, (*current)->type == DUP_OUT);
+    if (io < 0)
+        return (redir_fd_error(data, io));
     *current = (*current)->next;
-    return (1);
+    skip_whitespace_ptr(current);
+
+    if (!*current || (*current)->type != WORD)
+        return (0);
+
+    src = -1;
+    owned = 0;
+    if (ft_strcmp((*current)->content, "-"))
+    {
+        m = fd_word((*current)->content);
+        if (m == -2)
+        {
+            ft_putstr_fd("minishell: ", 2);
+            ft_putstr_fd((*current)->content, 2);
+            ft_putstr_fd(": ambiguous redirect\n", 2);
+            data->file_error = 1;
+            return (0);
+        }
+        if (m < 0)
+            return (redir_fd_error(data, m));
+        src = dup_cmd_fd(cmd, m, &owned);
+        if (src < 0)
+            return (redir_fd_error(data, m));
+    }
+    *current = (*current)->next;
+    return (set_cmd_fd(cmd, io, src, owned));
 }
 
 
@@ -173,43 +262,6 @@ void	skip_whitespace_ptr(t_elem **current)
 		*current = (*current)->next;
 }
 
-int	count_command_args(t_elem *start)
-{
-	int	count;
-	t_elem	*current;
-
-	count = 0;
-	current = start;
-	while (current && current->type != PIPE_LINE)
-	{
-		if (current->type == WORD || current->type == ENV)
-		{
-			if (!is_redirection_target(current, start))
-				count++;
-		}
-		current = current->next;
-	}
-	return (count);
-}
-
-// Fixed memory allocation with proper cleanup
-int	allocate_cmd_args(t_cmd *cmd, int arg_count)
-{
-	if (!cmd)
-		return (0);
-	if (arg_count <= 0)
-	{
-		cmd->full_cmd = NULL;
-		return (1);
-	}
-	cmd->full_cmd = malloc(sizeof(char *) * (arg_count + 1));
-	if (!cmd->full_cmd)
-		return (0);
-	ft_memset(cmd->full_cmd, 0, sizeof(char *) * (arg_count + 1));
-	return (1);
-}
-
-
 int	process_word_token(t_data *data, t_elem **current, t_cmd *cmd, int *arg_index)
 {
 	if (!data || !current || !*current || !cmd || !arg_index)
@@ -245,7 +297,8 @@ int	is_redirection_target(t_elem *elem, t_elem *start)
 	if (!current || !prev)
 		return (0);
 	return (prev->type == REDIR_IN || prev->type == REDIR_OUT ||
-		prev->type == DREDIR_OUT || prev->type == HERE_DOC);
+		prev->type == DREDIR_OUT || prev->type == HERE_DOC ||
+		prev->type == DUP_IN || prev->type == DUP_OUT);
 }
 
 
@@ -278,6 +331,7 @@ int	parse_pipeline(t_data *data)
 		if (!current_cmd)
 		{
 			free_cmd_list(data->head);
+			data->head = NULL;
 			return (0);
 		}
 		if (!data->head)
@@ -301,7 +355,10 @@ t_cmd	*parse_command(t_data *data, t_elem **current)
 		return (NULL);
 	cmd->in_file = STDIN_FILENO;
 	cmd->out_file = STDOUT_FILENO;
+	cmd->redirs = NULL;
 	cmd->full_cmd = NULL;
+	cmd->assigns = NULL;
+	cmd->pid = -1;
 	cmd->next = NULL;
 	if (!parse_arguments(data, current, cmd))
 	{
@@ -311,71 +368,205 @@ t_cmd	*parse_command(t_data *data, t_elem **current)
 	return (cmd);
 }
 
-// Fixed argument parsing with better error handling
-int	parse_arguments(t_data *data, t_elem **current, t_cmd *cmd)
+// Pushes the word, or the sorted names it matches when it is a pattern
+static int	push_word(t_argv *args, char *text, char *pattern,
+		t_env *env_list)
 {
-	int	arg_count;
-	int	arg_index;
+	char	**names;
+
+	names = NULL;
+	if (pattern)
+		names = glob_word(pattern, env_list);
+	free(pattern);
+	if (!names)
+		return (argv_push(args, text));
+	free(text);
+	return (argv_push_all(args, names));
+}
 
-	if (!data || !current || !cmd)
-		return (0);
-	arg_count = count_command_args(*current);
-	if (!allocate_cmd_args(cmd, arg_count))
-		return (0);
-	arg_index = 0;
-	while (*current && (*current)->type != PIPE_LINE)
-	{
-		skip_whitespace_ptr(current);
-		if (!*current || (*current)->type == PIPE_LINE)
-			break;
-		// Handle both WORD and ENV tokens as arguments
-		// 
-		else if ((*current)->type == WORD || (*current)->type == ENV)
+// Expands the braces of a word, whose words must fit in limit bytes
+// (0 for no limit)
+static int	push_braces(t_data *data, t_argv *args, char *pattern,
+		size_t limit)
 {
-	char *merged = ft_strdup((*current)->content);
-	if (!merged)
-		return (0);
+	t_brace	b;
+	int		ok;
+
+	b.args = args;
+	b.env = data->n_env;
+	b.limit = limit;
+	ok = brace_expand(&b, pattern);
+	free(pattern);
+	return (ok);
+}
 
-	t_elem *start = *current;
-	t_elem *next = (*current)->next;
+// Pushes the field built in w (see split.c): the words its braces give,
+// the sorted names it matches when it is a pattern, or its text. The
+// words of [[ ]] are not brace- or pathname-expanded. Returns -1 when the
+// words would not fit in w->limit.
+int	word_push(t_word *w)
+{
+	size_t	open;
+	size_t	close;
+	int		ok;
+
+	if (!w->text)
+		w->text = ft_strdup("");
+	if (!w->pattern)
+		w->pattern = ft_strdup("");
+	open = 0;
+	if (!w->text || !w->pattern)
+		ok = 0;
+	else if (!w->literal && brace_find(w->pattern, &open, &close))
+	{
+		free(w->text);
+		ok = push_braces(w->data, w->args, w->pattern, w->limit);
+	}
+	else
+	{
+		if (!w->magic || w->literal)
+			free(w->pattern);
+		if (!w->magic || w->literal)
+			w->pattern = NULL;
+		ok = push_word(w->args, w->text, w->pattern, w->data->n_env);
+	}
+	w->text = NULL;
+	w->pattern = NULL;
+	w->text_len = 0;
+	w->text_cap = 0;
+	w->pat_len = 0;
+	w->pat_cap = 0;
+	w->magic = 0;
+	w->started = 0;
+	if (ok > 0 && w->limit && w->args->bytes > w->limit)
+		return (-1);
+	return (ok);
+}
 
-	while (next && (next->type == WORD || next->type == ENV))
+// Adjacent WORD/ENV tokens ("a"$x'b') form one word, which field
+// splitting may cut into several arguments or none. Returns -1 when the
+// arguments would not fit in limit.
+static int	parse_word(t_data *data, t_elem **current, t_argv *args,
+		size_t limit)
+{
+	t_word	w;
+	int		ok;
+
+	ft_memset(&w, 0, sizeof(t_word));
+	w.data = data;
+	w.args = args;
+	w.limit = limit;
+	w.literal = (args->count && !ft_strcmp(args->v[0], "[["));
+	ok = 1;
+	while (ok > 0 && *current && ((*current)->type == WORD
+			|| (*current)->type == ENV))
 	{
-		// Check if there is whitespace between current and next
-		t_elem *tmp = start->next;
-		int separated_by_whitespace = 0;
-		while (tmp && tmp != next)
-		{
-			if (tmp->type == WHITE_SPACE)
-			{
-				separated_by_whitespace = 1;
-				break;
-			}
-			tmp = tmp->next;
-		}
-		if (separated_by_whitespace)
-			break;
+		ok = word_add_part(&w, *current);
+		*current = (*current)->next;
+	}
+	if (ok > 0 && w.started)
+		ok = word_push(&w);
+	free(w.text);
+	free(w.pattern);
+	return (ok);
+}
 
-		char *tmp_str = ft_strjoin(merged, next->content);
-		free(merged);
-		if (!tmp_str)
-			return (0);
-		merged = tmp_str;
+// Room left for the arguments of an external command once execve() has
+// the environment; SIZE_MAX when the words never reach execve()
+static size_t	arg_limit(t_data *data, char *name)
+{
+	long	max;
+	size_t	used;
+
+	max = sysconf(_SC_ARG_MAX);
+	if (data->words_only || max <= 0 || is_builtin(name)
+		|| find_function(name))
+		return (SIZE_MAX);
+	used = sizeof(char *) + data->n_env->bytes;
+	if (used >= (size_t)max)
+		return (1);
+	return (max - used);
+}
 
-		start = next;
-		next = next->next;
-	}
+// Reported before any work is done for the command, instead of the
+// E2BIG execve() would give
+static int	arg_list_too_long(t_data *data, char *name)
+{
+	ft_putstr_fd("minishell: ", 2);
+	ft_putstr_fd(name, 2);
+	ft_putstr_fd(": Argument list too long\n", 2);
+	data->file_error = 1;
+	return (0);
+}
 
-	if (cmd->full_cmd)
-		cmd->full_cmd[arg_index++] = merged;
+// "NAME=value" before the command name, with NAME and '=' written out in
+// the first token rather than coming from an expansion
+static int	is_assignment(t_data *data, t_elem *token, t_argv *args)
+{
+	int	i;
 
-	*current = start->next;
+	if (data->words_only || args->count || token->type != WORD
+		|| token->state != GENERAL || ft_isdigit(token->content[0]))
+		return (0);
+	i = 0;
+	while (is_valid_var_char(token->content[i]))
+		i++;
+	return (i > 0 && token->content[i] == '='
+		&& (!token->split || token->split[0] > i));
 }
 
-		else if (!process_redirection(data, current, cmd))
-			return (0);
+// A prefix assignment: its value is neither split nor globbed
+static int	parse_assignment(t_elem **current, t_argv *assigns)
+{
+	char	*text;
+	char	*joined;
+
+	text = ft_strdup("");
+	while (text && *current && ((*current)->type == WORD
+			|| (*current)->type == ENV))
+	{
+		joined = ft_strjoin(text, (*current)->content);
+		free(text);
+		text = joined;
+		*current = (*current)->next;
 	}
-	return (1);
+	return (argv_push(assigns, text));
+}
+
+int	parse_arguments(t_data *data, t_elem **current, t_cmd *cmd)
+{
+	t_argv	args;
+	t_argv	assigns;
+	size_t	limit;
+	int		ok;
+
+	if (!data || !current || !cmd)
+		return (0);
+	ft_memset(&args, 0, sizeof(t_argv));
+	ft_memset(&assigns, 0, sizeof(t_argv));
+	limit = 0;
+	ok = 1;
+	while (ok && *current && (*current)->type != PIPE_LINE)
+	{
+		skip_whitespace_ptr(current);
+		if (!*current || (*current)->type == PIPE_LINE)
+			break ;
+		if (is_assignment(data, *current, &args))
+			ok = parse_assignment(current, &assigns);
+		else if ((*current)->type == WORD || (*current)->type == ENV)
+		{
+			ok = parse_word(data, current, &args, limit);
+			if (ok > 0 && !limit && args.count)
+				limit = arg_limit(data, args.v[0]) - assigns.bytes;
+			if (ok < 0 || (ok > 0 && args.bytes > limit))
+				ok = arg_list_too_long(data, args.v[0]);
+		}
+		else
+			ok = process_redirection(data, current, cmd);
+	}
+	cmd->full_cmd = args.v;
+	cmd->assigns = assigns.v;
+	return (ok);
 }
 
 // Simplified redirection processing
@@ -391,6 +582,8 @@ int	process_redirection(t_data *data, t_elem **current, t_cmd *cmd)
 		return (handle_redirection_append(data, current, cmd));
 	if ((*current)->type == HERE_DOC)
 		return (handle_heredoc(data, current, cmd));
+	if ((*current)->type == DUP_IN || (*current)->type == DUP_OUT)
+		return (handle_redirection_dup(data, current, cmd));
 	*current = (*current)->next;
 	return (1);
 }
@@ -0,0 +1,588 @@
+#include "minishell.h"
+
+// Recursive descent over the lexed token list. A command list is a sequence
+// of commands separated by list operators; a command is either a pipeline,
+// which keeps its own token sub-list, or an if/while/until/for compound
+// whose parts are nested command lists. Reserved words are only recognised
+// as unquoted words at the start of a command. Every token ends up either
+// in a node or freed, so the caller's list is consumed.
+
+static enum e_list_op	list_op_of(enum e_type type)
+{
+	if (type == BACKGROUND)
+		return (OP_BACKGROUND);
+	if (type == SEMICOLON || type == NEW_LINE)
+		return (OP_SEQ);
+	if (type == AND_IF)
+		return (OP_AND);
+	if (type == OR_IF)
+		return (OP_OR);
+	return (OP_END);
+}
+
+static int	only_whitespace(t_elem *token, t_elem *end)
+{
+	while (token != end && token->type == WHITE_SPACE)
+		token = token->next;
+	return (token == end);
+}
+
+static t_node	*list_syntax_error(t_lparser *p)
+{
+	if (p->error)
+		return (NULL);
+	if (!p->cur)
+		ft_putstr_fd("minishell: syntax error: unexpected end of file\n", 2);
+	else
+	{
+		ft_putstr_fd("minishell: syntax error near unexpected token `", 2);
+		ft_putstr_fd(p->cur->content, 2);
+		ft_putstr_fd("'\n", 2);
+	}
+	p->error = 1;
+	return (NULL);
+}
+
+static void	drop_token(t_lparser *p)
+{
+	t_elem	*token;
+
+	token = p->cur;
+	p->cur = token->next;
+	token->next = NULL;
+	free_token_list(token);
+}
+
+static void	skip_blank(t_lparser *p, int newlines)
+{
+	while (p->cur && (p->cur->type == WHITE_SPACE
+			|| (newlines && p->cur->type == NEW_LINE)))
+		drop_token(p);
+}
+
+// The current token as a plain word (a keyword candidate), or NULL
+static char	*keyword_at(t_lparser *p)
+{
+	t_elem	*next;
+
+	skip_blank(p, 0);
+	if (!p->cur || p->cur->type != WORD || p->cur->state != GENERAL)
+		return (NULL);
+	next = p->cur->next;
+	if (next && next->type != WHITE_SPACE && list_op_of(next->type) == OP_END)
+		return (NULL);
+	return (p->cur->content);
+}
+
+// Whether word is one of the space separated words of list
+static int	word_in(const char *word, const char *list)
+{
+	size_t	len;
+
+	len = ft_strlen(word);
+	while (*list)
+	{
+		while (*list == ' ')
+			list++;
+		if (!ft_strncmp(list, word, len) && (list[len] == ' ' || !list[len]))
+			return (1);
+		while (*list && *list != ' ')
+			list++;
+	}
+	return (0);
+}
+
+static t_node	*new_node(enum e_node_kind kind)
+{
+	t_node	*node;
+
+	node = malloc(sizeof(t_node));
+	if (!node)
+		return (NULL);
+	ft_memset(node, 0, sizeof(t_node));
+	node->kind = kind;
+	node->op = OP_END;
+	return (node);
+}
+
+// Consumes the reserved word that must close or continue a compound
+static int	expect_keyword(t_lparser *p, const char *word, t_node *part)
+{
+	char	*kw;
+
+	if (p->error)
+		return (0);
+	kw = keyword_at(p);
+	if (!part || !kw || ft_strcmp(kw, word))
+	{
+		list_syntax_error(p);
+		return (0);
+	}
+	drop_token(p);
+	return (1);
+}
+
+static t_node	*parse_command_list(t_lparser *p, const char *stops);
+static t_node	*parse_list_command(t_lparser *p);
+
+// Cuts the tokens up to the next list operator into a pipeline node;
+// subshell parentheses are not supported
+static t_node	*parse_simple(t_lparser *p)
+{
+	t_node	*node;
+	t_elem	*start;
+	t_elem	*prev;
+
+	start = p->cur;
+	prev = NULL;
+	while (p->cur && list_op_of(p->cur->type) == OP_END
+		&& p->cur->type != LPAREN && p->cur->type != RPAREN)
+	{
+		prev = p->cur;
+		p->cur = p->cur->next;
+	}
+	if (!prev || only_whitespace(start, p->cur)
+		|| (p->cur && list_op_of(p->cur->type) == OP_END))
+	{
+		list_syntax_error(p);
+		p->cur = start;
+		return (NULL);
+	}
+	node = new_node(NODE_PIPELINE);
+	if (!node)
+	{
+		p->cur = start;
+		p->error = 1;
+		return (NULL);
+	}
+	prev->next = NULL;
+	node->tokens = start;
+	return (node);
+}
+
+// if list; then list; [elif list; then list;]... [else list;] fi
+// An elif is parsed as a nested if in the else part; it consumes the "fi".
+static t_node	*parse_if(t_lparser *p)
+{
+	t_node	*node;
+	char	*kw;
+
+	node = new_node(NODE_IF);
+	if (!node)
+		return (NULL);
+	drop_token(p);
+	node->cond = parse_command_list(p, "then");
+	if (expect_keyword(p, "then", node->cond))
+		node->body = parse_command_list(p, "elif else fi");
+	kw = keyword_at(p);
+	if (!p->error && (!node->body || !kw))
+		list_syntax_error(p);
+	else if (!p->error && !ft_strcmp(kw, "elif"))
+		node->alt = parse_if(p);
+	else if (!p->error && !ft_strcmp(kw, "else"))
+	{
+		drop_token(p);
+		node->alt = parse_command_list(p, "fi");
+		expect_keyword(p, "fi", node->alt);
+	}
+	else
+		expect_keyword(p, "fi", node->body);
+	if (!p->error)
+		return (node);
+	free_node_list(node);
+	return (NULL);
+}
+
+// while list; do list; done / until list; do list; done
+static t_node	*parse_loop(t_lparser *p, enum e_node_kind kind)
+{
+	t_node	*node;
+
+	node = new_node(kind);
+	if (!node)
+		return (NULL);
+	drop_token(p);
+	node->cond = parse_command_list(p, "do");
+	if (expect_keyword(p, "do", node->cond))
+		node->body = parse_command_list(p, "done");
+	expect_keyword(p, "done", node->body);
+	if (!p->error)
+		return (node);
+	free_node_list(node);
+	return (NULL);
+}
+
+// Detaches the words after "in" up to the ';' or newline that ends them
+static int	parse_for_words(t_lparser *p, t_node *node)
+{
+	t_elem	*start;
+	t_elem	*prev;
+
+	drop_token(p);
+	node->has_in = 1;
+	start = p->cur;
+	prev = NULL;
+	while (p->cur && (p->cur->type == WORD || p->cur->type == ENV
+			|| p->cur->type == EXIT_STATUS || p->cur->type == WHITE_SPACE
+			|| p->cur->type == ESCAPE))
+	{
+		prev = p->cur;
+		p->cur = p->cur->next;
+	}
+	if (p->cur && p->cur->type != SEMICOLON && p->cur->type != NEW_LINE)
+	{
+		list_syntax_error(p);
+		p->cur = start;
+		return (0);
+	}
+	if (prev)
+		prev->next = NULL;
+	if (prev && !only_whitespace(start, NULL))
+		node->tokens = start;
+	else if (prev)
+		free_token_list(start);
+	return (1);
+}
+
+// for name [in word...]; do list; done
+static t_node	*parse_for(t_lparser *p)
+{
+	t_node	*node;
+	char	*kw;
+
+	node = new_node(NODE_FOR);
+	if (!node)
+		return (NULL);
+	drop_token(p);
+	kw = keyword_at(p);
+	if (!kw || !is_valid_identifier(kw))
+		list_syntax_error(p);
+	else
+	{
+		node->var = ft_strdup(kw);
+		drop_token(p);
+		skip_blank(p, 1);
+		kw = keyword_at(p);
+		if (kw && !ft_strcmp(kw, "in"))
+			parse_for_words(p, node);
+		if (!p->error && p->cur && p->cur->type == SEMICOLON)
+			drop_token(p);
+		skip_blank(p, 1);
+		if (expect_keyword(p, "do", node))
+			node->body = parse_command_list(p, "done");
+		expect_keyword(p, "done", node->body);
+	}
+	if (!p->error && node->var)
+		return (node);
+	free_node_list(node);
+	return (NULL);
+}
+
+// { list; }: runs list in the current shell
+static t_node	*parse_group(t_lparser *p)
+{
+	t_node	*node;
+
+	node = new_node(NODE_GROUP);
+	if (!node)
+		return (NULL);
+	drop_token(p);
+	node->body = parse_command_list(p, "}");
+	expect_keyword(p, "}", node->body);
+	if (!p->error)
+		return (node);
+	free_node_list(node);
+	return (NULL);
+}
+
+// Whether the command starts with "name ( )"
+static int	is_funcdef(t_lparser *p)
+{
+	t_elem	*token;
+
+	token = p->cur;
+	if (!token || token->type != WORD || token->state != GENERAL
+		|| !is_valid_identifier(token->content))
+		return (0);
+	token = token->next;
+	while (token && token->type == WHITE_SPACE)
+		token = token->next;
+	if (!token || token->type != LPAREN)
+		return (0);
+	token = token->next;
+	while (token && token->type == WHITE_SPACE)
+		token = token->next;
+	return (token && token->type == RPAREN);
+}
+
+// Inside [[ ]] the operators && || < > ( ) are plain words for the builtin;
+// they are turned into words and kept apart from their neighbours
+static int	cond_operator_to_word(t_elem *prev, t_elem *token)
+{
+	t_elem	*space;
+
+	token->type = WORD;
+	if (prev->type != WHITE_SPACE)
+	{
+		space = create_token(" ", WHITE_SPACE, GENERAL);
+		if (!space)
+			return (0);
+		prev->next = space;
+		space->next = token;
+	}
+	if (token->next && token->next->type != WHITE_SPACE)
+	{
+		space = create_token(" ", WHITE_SPACE, GENERAL);
+		if (!space)
+			return (0);
+		space->next = token->next;
+		token->next = space;
+	}
+	return (1);
+}
+
+// [[ expression ]] runs as the [[ builtin once its operators are words
+static t_node	*parse_cond_command(t_lparser *p)
+{
+	t_elem	*start;
+	t_elem	*prev;
+	t_elem	*token;
+
+	start = p->cur;
+	prev = start;
+	token = prev->next;
+	while (token && !(token->type == WORD && token->state == GENERAL
+			&& !ft_strcmp(token->content, "]]")))
+	{
+		if ((token->type == AND_IF || token->type == OR_IF
+				|| token->type == REDIR_IN || token->type == REDIR_OUT
+				|| token->type == LPAREN || token->type == RPAREN)
+			&& !cond_operator_to_word(prev, token))
+			p->error = 1;
+		if (p->error || list_op_of(token->type) != OP_END)
+			break ;
+		prev = token;
+		token = token->next;
+	}
+	if (!p->error && (!token || token->type != WORD))
+	{
+		p->cur = token;
+		list_syntax_error(p);
+		p->cur = start;
+	}
+	if (p->error)
+		return (NULL);
+	return (parse_simple(p));
+}
+
+// name() compound-command
+static t_node	*parse_funcdef(t_lparser *p)
+{
+	t_node	*node;
+	char	*kw;
+
+	node = new_node(NODE_FUNCDEF);
+	if (!node)
+		return (NULL);
+	node->var = ft_strdup(p->cur->content);
+	while (p->cur->type != RPAREN)
+		drop_token(p);
+	drop_token(p);
+	skip_blank(p, 1);
+	kw = keyword_at(p);
+	if (!node->var || !kw || !word_in(kw, "{ if while until for"))
+		list_syntax_error(p);
+	else
+		node->body = parse_list_command(p);
+	if (!p->error && node->body)
+		return (node);
+	free_node_list(node);
+	return (NULL);
+}
+
+// time [-p|-v] command; a bare "time" times an empty command
+static t_node	*parse_time(t_lparser *p)
+{
+	t_node				*node;
+	char				*kw;
+	enum e_time_mode	mode;
+
+	drop_token(p);
+	mode = TIME_DEFAULT;
+	kw = keyword_at(p);
+	if (kw && (!ft_strcmp(kw, "-p") || !ft_strcmp(kw, "-v")))
+	{
+		mode = TIME_POSIX;
+		if (kw[1] == 'v')
+			mode = TIME_VERBOSE;
+		drop_token(p);
+		skip_blank(p, 0);
+	}
+	if (!p->cur || list_op_of(p->cur->type) != OP_END)
+	{
+		node = new_node(NODE_GROUP);
+		if (!node)
+			p->error = 1;
+	}
+	else
+		node = parse_list_command(p);
+	if (node)
+		node->timed = mode;
+	return (node);
+}
+
+static t_node	*parse_list_command(t_lparser *p)
+{
+	char	*kw;
+
+	kw = keyword_at(p);
+	if (kw && !ft_strcmp(kw, "time"))
+		return (parse_time(p));
+	if (is_funcdef(p))
+		return (parse_funcdef(p));
+	if (kw && !ft_strcmp(kw, "{"))
+		return (parse_group(p));
+	if (kw && !ft_strcmp(kw, "[["))
+		return (parse_cond_command(p));
+	if (kw && !ft_strcmp(kw, "if"))
+		return (parse_if(p));
+	if (kw && !ft_strcmp(kw, "while"))
+		return (parse_loop(p, NODE_WHILE));
+	if (kw && !ft_strcmp(kw, "until"))
+		return (parse_loop(p, NODE_UNTIL));
+	if (kw && !ft_strcmp(kw, "for"))
+		return (parse_for(p));
+	if (kw && word_in(kw, "then elif else fi do done }"))
+		return (list_syntax_error(p));
+	return (parse_simple(p));
+}
+
+// Parses commands until the end of input or one of the stop keywords.
+// A command must be followed by an operator, the end, or a stop keyword.
+static t_node	*parse_command_list(t_lparser *p, const char *stops)
+{
+	t_node	*head;
+	t_node	*last;
+	t_node	*node;
+	char	*kw;
+
+	head = NULL;
+	last = NULL;
+	while (!p->error)
+	{
+		skip_blank(p, 1);
+		kw = keyword_at(p);
+		if (!p->cur || (kw && word_in(kw, stops)))
+		{
+			if (last && (last->op == OP_AND || last->op == OP_OR))
+				list_syntax_error(p);
+			break ;
+		}
+		if (last && last->op == OP_END)
+		{
+			list_syntax_error(p);
+			break ;
+		}
+		node = parse_list_command(p);
+		if (!node)
+			break ;
+		if (!head)
+			head = node;
+		else
+			last->next = node;
+		last = node;
+		skip_blank(p, 0);
+		if (p->cur && list_op_of(p->cur->type) != OP_END)
+		{
+			last->op = list_op_of(p->cur->type);
+			drop_token(p);
+		}
+	}
+	if (!p->error && !(*stops && !head))
+		return (head);
+	if (!p->error && !p->cur)
+		list_syntax_error(p);
+	free_node_list(head);
+	return (NULL);
+}
+
+t_node	*parse_list(t_elem **tokens, int *error)
+{
+	t_lparser	p;
+	t_node		*list;
+
+	p.cur = *tokens;
+	p.error = 0;
+	list = parse_command_list(&p, "");
+	free_token_list(p.cur);
+	*tokens = NULL;
+	*error = p.error;
+	return (list);
+}
+
+void	free_node_list(t_node *list)
+{
+	t_node	*next;
+
+	while (list)
+	{
+		next = list->next;
+		free_token_list(list->tokens);
+		free(list->var);
+		free_node_list(list->cond);
+		free_node_list(list->body);
+		free_node_list(list->alt);
+		free(list);
+		list = next;
+	}
+}
+
+static int	copy_node_parts(t_node *node, t_node *src)
+{
+	node->op = src->op;
+	node->timed = src->timed;
+	node->has_in = src->has_in;
+	if (src->tokens)
+		node->tokens = copy_token_list(src->tokens);
+	if (src->var)
+		node->var = ft_strdup(src->var);
+	if (src->cond)
+		node->cond = copy_node_list(src->cond);
+	if (src->body)
+		node->body = copy_node_list(src->body);
+	if (src->alt)
+		node->alt = copy_node_list(src->alt);
+	return (!(src->tokens && !node->tokens) && !(src->var && !node->var)
+		&& !(src->cond && !node->cond) && !(src->body && !node->body)
+		&& !(src->alt && !node->alt));
+}
+
+// Deep copy of a command list, for function bodies that must outlive the
+// line that defined them
+t_node	*copy_node_list(t_node *list)
+{
+	t_node	*head;
+	t_node	*last;
+	t_node	*node;
+
+	head = NULL;
+	last = NULL;
+	while (list)
+	{
+		node = new_node(list->kind);
+		if (!node)
+			break ;
+		if (!head)
+			head = node;
+		else
+			last->next = node;
+		last = node;
+		if (!copy_node_parts(node, list))
+			break ;
+		list = list->next;
+	}
+	if (!list)
+		return (head);
+	free_node_list(head);
+	return (NULL);
+}
@@ -0,0 +1,172 @@
+#include "minishell.h"
+
+// LRU cache of parsed command lists keyed by the raw input line. A cached
+// list is never modified: run_pipeline_node() expands a copy of each
+// pipeline's tokens, so a hit only pays for expansion and redirections.
+// Entries are pinned while they run so that a nested process_input() (a
+// parallel job, a function body) cannot evict the list under our feet.
+
+static t_pcache	g_pcache = {NULL, NULL, 0, 0, 0};
+
+static unsigned long	hash_input(const char *s)
+{
+	unsigned long	h;
+
+	h = 5381;
+	while (*s)
+		h = h * 33 + (unsigned char)*s++;
+	return (h);
+}
+
+static void	unlink_entry(t_pentry *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		g_pcache.head = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		g_pcache.tail = entry->prev;
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+static void	push_front(t_pentry *entry)
+{
+	entry->next = g_pcache.head;
+	if (g_pcache.head)
+		g_pcache.head->prev = entry;
+	g_pcache.head = entry;
+	if (!g_pcache.tail)
+		g_pcache.tail = entry;
+}
+
+static void	drop_entry(t_pentry *entry)
+{
+	unlink_entry(entry);
+	free(entry->input);
+	free_node_list(entry->list);
+	free(entry);
+	g_pcache.count--;
+}
+
+// Returns the pinned cached list for input, or NULL on a miss
+t_node	*parse_cache_get(const char *input)
+{
+	t_pentry		*entry;
+	unsigned long	hash;
+
+	hash = hash_input(input);
+	entry = g_pcache.head;
+	while (entry && (entry->hash != hash || ft_strcmp(entry->input, input)))
+		entry = entry->next;
+	if (!entry)
+	{
+		g_pcache.misses++;
+		return (NULL);
+	}
+	g_pcache.hits++;
+	unlink_entry(entry);
+	push_front(entry);
+	entry->pins++;
+	return (entry->list);
+}
+
+// Hands list over to the cache and pins it. Returns 0 when the cache is full
+// of running lists; the caller then keeps ownership.
+int	parse_cache_put(const char *input, t_node *list)
+{
+	t_pentry	*entry;
+	t_pentry	*victim;
+
+	victim = g_pcache.tail;
+	while (g_pcache.count >= PARSE_CACHE_SIZE && victim && victim->pins)
+		victim = victim->prev;
+	if (g_pcache.count >= PARSE_CACHE_SIZE && !victim)
+		return (0);
+	entry = malloc(sizeof(t_pentry));
+	if (!entry)
+		return (0);
+	entry->input = ft_strdup(input);
+	if (!entry->input)
+		return (free(entry), 0);
+	if (g_pcache.count >= PARSE_CACHE_SIZE)
+		drop_entry(victim);
+	entry->hash = hash_input(input);
+	entry->list = list;
+	entry->pins = 1;
+	entry->prev = NULL;
+	push_front(entry);
+	g_pcache.count++;
+	return (1);
+}
+
+void	parse_cache_release(t_node *list)
+{
+	t_pentry	*entry;
+
+	entry = g_pcache.head;
+	while (entry && entry->list != list)
+		entry = entry->next;
+	if (entry && entry->pins)
+		entry->pins--;
+}
+
+// Pinned list for input, parsed and cached on a miss. *cached says whether
+// parse_cache_release() or free_node_list() gives it back. NULL with *error
+// clear means there was nothing to run.
+t_node	*parse_cache_lookup(char *input, int *cached, int *error)
+{
+	t_node	*list;
+
+	*error = 0;
+	list = parse_cache_get(input);
+	*cached = (list != NULL);
+	if (list)
+		return (list);
+	list = parse_input_line(input, error);
+	if (list)
+		*cached = parse_cache_put(input, list);
+	return (list);
+}
+
+static void	clear_parse_cache(void)
+{
+	t_pentry	*entry;
+	t_pentry	*next;
+
+	entry = g_pcache.head;
+	while (entry)
+	{
+		next = entry->next;
+		if (!entry->pins)
+			drop_entry(entry);
+		entry = next;
+	}
+	g_pcache.hits = 0;
+	g_pcache.misses = 0;
+}
+
+// parsecache [-r]: prints hit/miss counters, -r clears the cache and counters
+int	builtin_parsecache(char **args)
+{
+	unsigned long	lookups;
+
+	if (args[1] && !ft_strcmp(args[1], "-r") && !args[2])
+	{
+		clear_parse_cache();
+		return (0);
+	}
+	if (args[1])
+	{
+		ft_putstr_fd("minishell: parsecache: usage: parsecache [-r]\n", 2);
+		return (2);
+	}
+	lookups = g_pcache.hits + g_pcache.misses;
+	printf("hits\t%lu\nmisses\t%lu\nentries\t%d/%d\n", g_pcache.hits,
+		g_pcache.misses, g_pcache.count, PARSE_CACHE_SIZE);
+	if (lookups)
+		printf("ratio\t%lu%%\n", g_pcache.hits * 100 / lookups);
+	return (0);
+}